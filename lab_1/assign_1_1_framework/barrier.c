@@ -0,0 +1,77 @@
+/*
+ * barrier.c
+ *
+ * Sense-reversing spin-then-sleep barrier.
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "barrier.h"
+
+/* Default spin budget; override with WAVE_SPIN (0 = always sleep). */
+#define SPIN_DEFAULT 20000
+
+int spin_barrier_init(spin_barrier_t *b, int n)
+{
+    const char *env = getenv("WAVE_SPIN");
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    atomic_init(&b->count, n);
+    atomic_init(&b->sense, 0);
+    atomic_init(&b->sleepers, 0);
+    b->n = n;
+
+    /* spinning only pays off when every participant has its own core */
+    if (env && *env)
+        b->spin = atoi(env);
+    else
+        b->spin = (ncpu > 0 && n > ncpu) ? 0 : SPIN_DEFAULT;
+
+    if (pthread_mutex_init(&b->mtx, NULL) != 0)
+        return -1;
+    if (pthread_cond_init(&b->cv, NULL) != 0) {
+        pthread_mutex_destroy(&b->mtx);
+        return -1;
+    }
+    return 0;
+}
+
+void spin_barrier_destroy(spin_barrier_t *b)
+{
+    pthread_cond_destroy(&b->cv);
+    pthread_mutex_destroy(&b->mtx);
+}
+
+void spin_barrier_wait(spin_barrier_t *b, int *local_sense)
+{
+    int my = !*local_sense;
+    *local_sense = my;
+
+    if (atomic_fetch_sub(&b->count, 1) == 1) {
+        /* last arrival: re-arm and release everybody */
+        atomic_store_explicit(&b->count, b->n, memory_order_relaxed);
+        atomic_store(&b->sense, my);
+        if (atomic_load(&b->sleepers) > 0) {
+            pthread_mutex_lock(&b->mtx);
+            pthread_cond_broadcast(&b->cv);
+            pthread_mutex_unlock(&b->mtx);
+        }
+        return;
+    }
+
+    for (int i = 0; i < b->spin; ++i) {
+        if (atomic_load_explicit(&b->sense, memory_order_acquire) == my)
+            return;
+        cpu_relax();
+    }
+
+    /* the sleepers increment and the sense check are both seq_cst, so either
+       we see the flip here or the releaser sees us and broadcasts */
+    pthread_mutex_lock(&b->mtx);
+    atomic_fetch_add(&b->sleepers, 1);
+    while (atomic_load(&b->sense) != my)
+        pthread_cond_wait(&b->cv, &b->mtx);
+    atomic_fetch_sub(&b->sleepers, 1);
+    pthread_mutex_unlock(&b->mtx);
+}
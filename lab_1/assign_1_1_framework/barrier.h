@@ -0,0 +1,37 @@
+/*
+ * barrier.h
+ *
+ * Sense-reversing spin-then-sleep barrier. Threads spin on a shared sense
+ * flag for a bounded number of iterations and only then fall back to a
+ * condition variable, so short waits never enter the kernel.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+static inline void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+typedef struct {
+    atomic_int      count;     /* threads still to arrive in this phase */
+    atomic_int      sense;     /* flips every time the barrier opens */
+    atomic_int      sleepers;  /* threads blocked on the condvar */
+    int             n;         /* number of participating threads */
+    int             spin;      /* spin iterations before sleeping */
+    pthread_mutex_t mtx;
+    pthread_cond_t  cv;
+} spin_barrier_t;
+
+/* Initialize/destroy the barrier for n threads. Returns 0 on success. */
+int  spin_barrier_init(spin_barrier_t *b, int n);
+void spin_barrier_destroy(spin_barrier_t *b);
+
+/* Wait until all n threads arrived. `local_sense' is per-thread state that
+   must start at 0 and is only touched by its owner. */
+void spin_barrier_wait(spin_barrier_t *b, int *local_sense);
@@ -0,0 +1,121 @@
+/*
+ * bench_batch.c
+ *
+ * Throughput of simulate_batch() against calling simulate() once per
+ * string, in strings per second. Every string starts from one sine period
+ * with its own wavelength, so the strings differ and a mix-up between them
+ * shows in the deviation.
+ *
+ * Usage: bench_batch i_max t_max nstrings num_threads
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "simulate.h"
+#include "timer.h"
+
+#define PI 3.14159265358979323846
+
+/* Fills string s of both generations; point i sits at base[i * step]. */
+static void init_string(double *old, double *cur, int i_max, int s,
+        size_t step)
+{
+    const double k = 1.0 + (s % 7);
+
+    for (int i = 0; i < i_max; ++i) {
+        double x = (i == 0 || i == i_max - 1) ? 0.0
+                 : sin(PI * k * i / (i_max - 1));
+        old[i * step] = x;
+        cur[i * step] = x;
+    }
+}
+
+static double *alloc_doubles(size_t n)
+{
+    double *a = malloc(sizeof(double) * n);
+    if (!a) {
+        fprintf(stderr, "Could not allocate %zu doubles.\n", n);
+        exit(EXIT_FAILURE);
+    }
+    return a;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 5) {
+        printf("Usage: %s i_max t_max nstrings num_threads\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const int i_max = atoi(argv[1]);
+    const int t_max = atoi(argv[2]);
+    const int nstrings = atoi(argv[3]);
+    const int num_threads = atoi(argv[4]);
+
+    if (i_max < 3 || t_max < 1 || nstrings < 1 || num_threads < 1) {
+        fprintf(stderr, "argument error\n");
+        return EXIT_FAILURE;
+    }
+
+    const size_t n = (size_t)i_max * nstrings;
+    double *bufs[3] = { alloc_doubles(n), alloc_doubles(n), alloc_doubles(n) };
+    double *ref = alloc_doubles(n);
+    double *ret, time;
+
+    /* simulate() once per string */
+    for (int s = 0; s < nstrings; ++s)
+        init_string(bufs[0] + (size_t)s * i_max, bufs[1] + (size_t)s * i_max,
+                    i_max, s, 1);
+    timer_start();
+    for (int s = 0; s < nstrings; ++s) {
+        size_t off = (size_t)s * i_max;
+        simulate(i_max, t_max, num_threads, bufs[0] + off, bufs[1] + off,
+                 bufs[2] + off);
+    }
+    time = timer_end();
+    /* every call leaves its result in the same rotation slot */
+    ret = bufs[(t_max + 1) % 3];
+    memcpy(ref, ret, sizeof(double) * n);
+    printf("simulate() loop:       %10.4f s  %12.1f strings/s\n",
+           time, nstrings / time);
+
+    /* the same strings back to back */
+    for (int s = 0; s < nstrings; ++s)
+        init_string(bufs[0] + (size_t)s * i_max, bufs[1] + (size_t)s * i_max,
+                    i_max, s, 1);
+    timer_start();
+    ret = simulate_batch(i_max, t_max, num_threads, nstrings, WAVE_BATCH_SOA,
+                         bufs[0], bufs[1], bufs[2]);
+    time = timer_end();
+    double dev = 0.0;
+    for (size_t j = 0; j < n; ++j)
+        dev = fmax(dev, fabs(ret[j] - ref[j]));
+    printf("simulate_batch(soa):   %10.4f s  %12.1f strings/s  "
+           "max deviation %g\n", time, nstrings / time, dev);
+
+    /* and interleaved */
+    for (int s = 0; s < nstrings; ++s)
+        init_string(bufs[0] + s, bufs[1] + s, i_max, s, (size_t)nstrings);
+    timer_start();
+    ret = simulate_batch(i_max, t_max, num_threads, nstrings,
+                         WAVE_BATCH_INTERLEAVED, bufs[0], bufs[1], bufs[2]);
+    time = timer_end();
+    dev = 0.0;
+    for (int s = 0; s < nstrings; ++s) {
+        for (int i = 0; i < i_max; ++i) {
+            dev = fmax(dev, fabs(ret[(size_t)i * nstrings + s]
+                                 - ref[(size_t)s * i_max + i]));
+        }
+    }
+    printf("simulate_batch(inter): %10.4f s  %12.1f strings/s  "
+           "max deviation %g\n", time, nstrings / time, dev);
+
+    free(bufs[0]);
+    free(bufs[1]);
+    free(bufs[2]);
+    free(ref);
+    return EXIT_SUCCESS;
+}
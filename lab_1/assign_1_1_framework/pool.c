@@ -0,0 +1,142 @@
+/*
+ * pool.c
+ *
+ * Process-lifetime worker pool on top of the spin barrier. Idle workers park
+ * on the `start' barrier (spinning briefly, then sleeping); the caller joins
+ * that barrier to hand out a job and the `done' barrier to wait for it.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "barrier.h"
+#include "pool.h"
+
+static struct {
+    int             active;
+    int             n;
+    pthread_t      *threads;
+    int            *ids;
+    spin_barrier_t  start;
+    spin_barrier_t  done;
+    int             start_sense;   /* caller side of the barriers */
+    int             done_sense;
+    pthread_mutex_t busy;          /* one job at a time */
+
+    /* current job; fn == NULL asks the workers to exit */
+    pool_fn_t       fn;
+    char           *args;
+    size_t          arg_size;
+    int             njobs;
+} pool;
+
+static void *pool_worker(void *arg)
+{
+    int id = *(int *)arg;
+    int start_sense = 0, done_sense = 0;
+
+    for (;;) {
+        spin_barrier_wait(&pool.start, &start_sense);
+        if (!pool.fn)
+            break;
+        if (id < pool.njobs)
+            pool.fn(pool.args + (size_t)id * pool.arg_size);
+        spin_barrier_wait(&pool.done, &done_sense);
+    }
+    return NULL;
+}
+
+int pool_init(int num_threads)
+{
+    if (pool.active || num_threads < 1)
+        return -1;
+
+    pool.threads = malloc(sizeof(pthread_t) * num_threads);
+    pool.ids = malloc(sizeof(int) * num_threads);
+    if (!pool.threads || !pool.ids)
+        goto fail_alloc;
+
+    if (spin_barrier_init(&pool.start, num_threads + 1) != 0)
+        goto fail_alloc;
+    if (spin_barrier_init(&pool.done, num_threads + 1) != 0)
+        goto fail_start;
+    if (pthread_mutex_init(&pool.busy, NULL) != 0)
+        goto fail_done;
+
+    pool.n = num_threads;
+    pool.fn = NULL;
+    pool.start_sense = pool.done_sense = 0;
+
+    for (int i = 0; i < num_threads; ++i) {
+        pool.ids[i] = i;
+        if (pthread_create(&pool.threads[i], NULL, pool_worker,
+                           &pool.ids[i]) != 0) {
+            /* shrink the barriers to the threads that did start; the
+               caller has not arrived yet, so nobody can be released early */
+            pool.start.n = pool.done.n = i + 1;
+            atomic_fetch_sub(&pool.start.count, num_threads - i);
+            atomic_fetch_sub(&pool.done.count, num_threads - i);
+            pool.n = i;
+            break;
+        }
+    }
+
+    pool.active = 1;
+    if (pool.n == 0) {
+        pool_shutdown();
+        return -1;
+    }
+    return 0;
+
+fail_done:
+    spin_barrier_destroy(&pool.done);
+fail_start:
+    spin_barrier_destroy(&pool.start);
+fail_alloc:
+    free(pool.threads);
+    free(pool.ids);
+    pool.threads = NULL;
+    pool.ids = NULL;
+    return -1;
+}
+
+void pool_shutdown(void)
+{
+    if (!pool.active)
+        return;
+
+    pthread_mutex_lock(&pool.busy);
+    pool.fn = NULL;
+    spin_barrier_wait(&pool.start, &pool.start_sense);
+    for (int i = 0; i < pool.n; ++i)
+        pthread_join(pool.threads[i], NULL);
+    pthread_mutex_unlock(&pool.busy);
+
+    spin_barrier_destroy(&pool.start);
+    spin_barrier_destroy(&pool.done);
+    pthread_mutex_destroy(&pool.busy);
+    free(pool.threads);
+    free(pool.ids);
+    pool.threads = NULL;
+    pool.ids = NULL;
+    pool.active = 0;
+}
+
+int pool_run(pool_fn_t fn, void *args, size_t arg_size, int n)
+{
+    if (!pool.active || n > pool.n || !fn)
+        return -1;
+    if (pthread_mutex_trylock(&pool.busy) != 0)
+        return -1;
+
+    pool.fn = fn;
+    pool.args = args;
+    pool.arg_size = arg_size;
+    pool.njobs = n;
+
+    spin_barrier_wait(&pool.start, &pool.start_sense);
+    spin_barrier_wait(&pool.done, &pool.done_sense);
+
+    pthread_mutex_unlock(&pool.busy);
+    return 0;
+}
@@ -0,0 +1,24 @@
+/*
+ * pool.h
+ *
+ * Process-lifetime worker pool. After pool_init() every simulate() call runs
+ * on the same parked threads instead of creating and joining fresh ones.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef void *(*pool_fn_t)(void *arg);
+
+/* Start num_threads parked workers. Returns 0 on success. Not thread-safe
+   with respect to pool_run() or pool_shutdown(). */
+int  pool_init(int num_threads);
+
+/* Wake, stop and join all workers. Safe to call when no pool is running. */
+void pool_shutdown(void);
+
+/* Run fn on n workers; worker i receives (char *)args + i * arg_size.
+   Blocks until all n calls returned. Returns -1 without running anything
+   when there is no pool, it has fewer than n workers or it is busy. */
+int  pool_run(pool_fn_t fn, void *args, size_t arg_size, int n);
@@ -0,0 +1,490 @@
+/*
+ * server.c
+ *
+ * Daemon mode of assign1_1, see server.h.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "initial.h"
+#include "pool.h"
+#include "precision.h"
+#include "server.h"
+#include "simulate.h"
+#include "wave_kernels.h"
+#include "wave_proto.h"
+#include "window.h"
+
+#define MAX_CLIENTS 64
+#define MAX_JOBS 256
+
+/* Largest wave the server accepts, 3 arrays of 1 GiB. */
+#define MAX_I_MAX (1 << 27)
+
+#define DEFAULT_BATCH 4096
+
+/* Milliseconds a reply may wait for a client to read, WAVE_SERVE_TIMEOUT. */
+#define DEFAULT_TIMEOUT 1000
+
+/* Speed of the batch kernel per point over the barrier solver's, one
+   thread, strings in L1/L2. */
+#define BATCH_GAIN 1.5
+
+typedef struct {
+    int fd;                /* -1 when the slot is free */
+    size_t have;           /* bytes of req read so far */
+    wave_request_t req;
+} client_t;
+
+typedef struct {
+    int client;            /* slot of the sender, -1 once it hung up */
+    wave_request_t req;
+    int batchable;
+    int group;             /* first job of its batch, or itself */
+    int done;              /* reply ready */
+    const double *result;
+    wave_reply_t reply;
+} job_t;
+
+static volatile sig_atomic_t stop;
+static int send_timeout = DEFAULT_TIMEOUT;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *init_name(int init)
+{
+    switch (init) {
+    case WAVE_INIT_SIN: return "sin";
+    case WAVE_INIT_SINFULL: return "sinfull";
+    case WAVE_INIT_GAUSS: return "gauss";
+    default: return NULL;
+    }
+}
+
+static int env_int(const char *name, int def)
+{
+    const char *env = getenv(name);
+    return (env && *env) ? atoi(env) : def;
+}
+
+static int set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    return (flags < 0) ? -1 : fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* Writes all of buf, waiting for the socket to drain when it is full.
+   Returns 0, or -1 when the client is gone or has not made room within
+   send_timeout ms: the loop serves everyone, so a client that stops
+   reading its replies must not hold up the others. */
+static int send_all(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    const double deadline = now() + 1e-3 * send_timeout;
+
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            int left = (int)(1e3 * (deadline - now()));
+            if (left <= 0 || poll(&pfd, 1, left) == 0) {
+                fprintf(stderr, "Dropping a client that does not read its "
+                        "replies.\n");
+                return -1;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void drop_client(client_t *c, job_t *jobs, int njobs, int slot)
+{
+    close(c->fd);
+    c->fd = -1;
+    c->have = 0;
+    for (int j = 0; j < njobs; ++j)
+        if (jobs[j].client == slot)
+            jobs[j].client = -1;
+}
+
+/* Reads whole requests from client slot until it would block or the round
+   is full. */
+static void read_requests(client_t *clients, int slot, job_t *jobs,
+        int *njobs)
+{
+    client_t *c = &clients[slot];
+
+    while (*njobs < MAX_JOBS) {
+        ssize_t n = recv(c->fd, (char *)&c->req + c->have,
+                         sizeof(c->req) - c->have, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n <= 0) {
+            drop_client(c, jobs, *njobs, slot);
+            return;
+        }
+        c->have += (size_t)n;
+        if (c->have == sizeof(c->req)) {
+            job_t *j = &jobs[(*njobs)++];
+            memset(j, 0, sizeof(*j));
+            j->client = slot;
+            j->req = c->req;
+            c->have = 0;
+        }
+    }
+}
+
+/* Accepts new clients and reads what the known ones sent, waiting at most
+   timeout ms for anything to happen. */
+static void collect(int listen_fd, client_t *clients, job_t *jobs,
+        int *njobs, int timeout)
+{
+    struct pollfd pfds[MAX_CLIENTS + 1];
+    int slots[MAX_CLIENTS + 1], n = 0;
+
+    pfds[n].fd = listen_fd;
+    pfds[n].events = POLLIN;
+    slots[n++] = -1;
+    for (int s = 0; s < MAX_CLIENTS; ++s) {
+        if (clients[s].fd >= 0) {
+            pfds[n].fd = clients[s].fd;
+            pfds[n].events = POLLIN;
+            slots[n++] = s;
+        }
+    }
+
+    if (poll(pfds, n, timeout) <= 0)
+        return;
+
+    if (pfds[0].revents & POLLIN) {
+        int fd;
+        while ((fd = accept(listen_fd, NULL, NULL)) >= 0) {
+            int s = 0;
+            while (s < MAX_CLIENTS && clients[s].fd >= 0)
+                ++s;
+            if (s == MAX_CLIENTS || set_nonblocking(fd) != 0) {
+                close(fd);
+                continue;
+            }
+            clients[s].fd = fd;
+            clients[s].have = 0;
+        }
+    }
+    for (int p = 1; p < n; ++p)
+        if (pfds[p].revents & (POLLIN | POLLHUP | POLLERR))
+            read_requests(clients, slots[p], jobs, njobs);
+}
+
+/*
+ * Share of t_max full sweeps the barrier solver computes for r: it only
+ * sweeps the active window (window.h), which starts at the nonzero part of
+ * the initial data and grows a point per side and step. The batch kernel
+ * always sweeps whole strings, so a job whose window stays narrow is
+ * cheaper alone. scratch holds 2 * i_max doubles.
+ */
+static double window_share(const wave_request_t *r, double *scratch)
+{
+    const int i_max = r->i_max;
+    const double inner = i_max - 2;
+    double *old = scratch, *cur = scratch + i_max;
+    int lo, hi;
+
+    memset(scratch, 0, sizeof(double) * 2 * (size_t)i_max);
+    wave_initial(init_name(r->init), old, cur, i_max);
+    wave_window(old, cur, i_max, &lo, &hi);
+
+    /* steps until the window covers the interior; each step before adds
+       two points */
+    const double w = (lo <= hi) ? hi - lo + 1 : 0;
+    const double full = (inner - w) / 2;
+    if (full >= r->t_max)
+        return (w + (r->t_max - 1)) / inner;
+    return (full * (w + full - 1) + (r->t_max - full) * inner)
+           / (inner * r->t_max);
+}
+
+static int valid(const wave_request_t *r)
+{
+    return r->magic == WAVE_PROTO_MAGIC && r->i_max >= 3
+        && r->i_max <= MAX_I_MAX && r->t_max >= 1 && init_name(r->init);
+}
+
+/* Sends the reply of job j, if its client is still there. */
+static void send_reply(client_t *clients, job_t *jobs, int njobs, int j)
+{
+    job_t *J = &jobs[j];
+    const int ok = J->reply.status == WAVE_REPLY_OK;
+
+    if (J->client < 0)
+        return;
+    J->reply.i_max = ok ? J->req.i_max : 0;
+    if (send_all(clients[J->client].fd, &J->reply, sizeof(J->reply)) != 0
+            || (ok && send_all(clients[J->client].fd, J->result,
+                               sizeof(double) * (size_t)J->req.i_max) != 0))
+        drop_client(&clients[J->client], jobs, njobs, J->client);
+}
+
+/*
+ * Runs one round of jobs. Jobs of the same i_max and t_max up to
+ * batch_max points share one simulate_batch() call, unless the active
+ * window makes them cheaper alone; the others run alone.
+ * Replies go out in request order as soon as they are ready. The arrays
+ * come from the arena, whose mapping is kept from round to round, and
+ * whenever every finished job has been answered the arena is reset, so
+ * jobs that run one after another reuse the same memory while it is
+ * still in cache.
+ */
+static void run_round(client_t *clients, job_t *jobs, int njobs,
+        int num_threads, int batch_max, double *scratch, wave_arena_t *arena)
+{
+    int count[MAX_JOBS];
+    size_t bytes = 0;
+    int sent = 0;
+
+    /* group the jobs; count[g] is the size of the batch g starts */
+    for (int j = 0; j < njobs; ++j) {
+        job_t *J = &jobs[j];
+
+        J->group = j;
+        count[j] = 0;
+        if (!valid(&J->req)) {
+            J->group = -1;
+            J->reply.status = WAVE_REPLY_BAD_REQUEST;
+            J->done = 1;
+            continue;
+        }
+        J->batchable = J->req.i_max <= batch_max
+            && window_share(&J->req, scratch) * BATCH_GAIN > 1.0;
+        for (int g = 0; g < j && J->batchable; ++g) {
+            if (jobs[g].group == g && jobs[g].batchable
+                    && jobs[g].req.i_max == J->req.i_max
+                    && jobs[g].req.t_max == J->req.t_max) {
+                J->group = g;
+                break;
+            }
+        }
+        ++count[J->group];
+    }
+    for (int g = 0; g < njobs; ++g) {
+        if (jobs[g].group == g)
+            bytes += 3 * WAVE_ARENA_CHUNK(sizeof(double)
+                    * (size_t)jobs[g].req.i_max * count[g]);
+    }
+
+    if (bytes && wave_arena_reserve(arena, bytes) != 0) {
+        for (int j = 0; j < njobs; ++j) {
+            if (jobs[j].group >= 0)
+                jobs[j].reply.status = WAVE_REPLY_NO_MEMORY;
+            send_reply(clients, jobs, njobs, j);
+        }
+        return;
+    }
+
+    for (int g = 0; g < njobs; ++g) {
+        if (jobs[g].group != g)
+            continue;
+
+        /* skip batches whose clients have all been dropped */
+        int wanted = 0;
+        for (int j = g; j < njobs; ++j)
+            wanted |= jobs[j].group == g && jobs[j].client >= 0;
+        if (!wanted) {
+            for (int j = g; j < njobs; ++j)
+                jobs[j].done |= jobs[j].group == g;
+            continue;
+        }
+
+        const int i_max = jobs[g].req.i_max, t_max = jobs[g].req.t_max;
+        const int n = count[g];
+        const size_t len = sizeof(double) * (size_t)i_max * n;
+        double *old = wave_arena_alloc(arena, len, 0);
+        double *cur = wave_arena_alloc(arena, len, 0);
+        double *next = wave_arena_alloc(arena, len, 0);
+        const double *res = NULL;
+        double t0;
+
+        /* string k of the batch is the k-th job of the group */
+        for (int j = g, k = 0; j < njobs; ++j) {
+            if (jobs[j].group == g) {
+                wave_initial(init_name(jobs[j].req.init),
+                        old + (size_t)k * i_max, cur + (size_t)k * i_max,
+                        i_max);
+                ++k;
+            }
+        }
+
+        t0 = now();
+        if (n > 1) {
+            res = simulate_batch(i_max, t_max, num_threads, n,
+                    WAVE_BATCH_SOA, old, cur, next);
+        } else {
+            wave_ctx_t *ctx = wave_ctx_create(i_max, num_threads, old, cur,
+                                              next);
+            if (ctx) {
+                wave_step(ctx, t_max);
+                res = wave_view(ctx, NULL);
+                wave_destroy(ctx);
+            }
+        }
+        const double seconds = now() - t0;
+
+        for (int j = g, k = 0; j < njobs; ++j) {
+            if (jobs[j].group != g)
+                continue;
+            jobs[j].reply.status = res ? WAVE_REPLY_OK : WAVE_REPLY_NO_MEMORY;
+            jobs[j].reply.batch = n;
+            jobs[j].reply.seconds = seconds;
+            jobs[j].result = res ? res + (size_t)k * i_max : NULL;
+            jobs[j].done = 1;
+            ++k;
+        }
+
+        while (sent < njobs && jobs[sent].done)
+            send_reply(clients, jobs, njobs, sent++);
+        int pending = 0;
+        for (int j = sent; j < njobs; ++j)
+            pending |= jobs[j].done && jobs[j].group >= 0;
+        if (!pending)
+            wave_arena_reset(arena);
+    }
+    while (sent < njobs)
+        send_reply(clients, jobs, njobs, sent++);
+}
+
+int wave_serve(const char *path, int num_threads)
+{
+    static client_t clients[MAX_CLIENTS];
+    static job_t jobs[MAX_JOBS];
+    int batch_max = env_int("WAVE_SERVE_BATCH", DEFAULT_BATCH);
+    const int wait_us = env_int("WAVE_SERVE_WAIT", 0);
+    wave_arena_t arena = { 0 };
+    struct sockaddr_un addr;
+    struct sigaction sa;
+    long served = 0, batched = 0, rounds = 0;
+    double *scratch = NULL;
+    int listen_fd;
+
+    send_timeout = env_int("WAVE_SERVE_TIMEOUT", DEFAULT_TIMEOUT);
+    if (num_threads < 1) {
+        printf("argument error: num_threads should be >=1.\n");
+        return EXIT_FAILURE;
+    }
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("argument error: socket path too long.\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    /* a client that hangs up shows as a failed send, not a signal */
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr,
+                              sizeof(addr)) != 0
+            || listen(listen_fd, MAX_CLIENTS) != 0
+            || set_nonblocking(listen_fd) != 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* simulate_batch() has only the plain stencil */
+    if (batch_max > 0 && (wave_order() == 4 || getenv("WAVE_COEFF")
+                          || wave_precision() != WAVE_DOUBLE)) {
+        fprintf(stderr, "Batching needs the plain double stencil; "
+                "WAVE_SERVE_BATCH=0.\n");
+        batch_max = 0;
+    }
+    if (batch_max > 0
+            && !(scratch = malloc(sizeof(double) * 2 * (size_t)batch_max))) {
+        fprintf(stderr, "Scratch allocation failed; WAVE_SERVE_BATCH=0.\n");
+        batch_max = 0;
+    }
+
+    /* the workers stay parked between jobs */
+    if (pool_init(num_threads) != 0)
+        fprintf(stderr, "Worker pool failed to start; threads are created "
+                "per job.\n");
+    for (int s = 0; s < MAX_CLIENTS; ++s)
+        clients[s].fd = -1;
+
+    printf("Serving on %s with %d threads\n", path, num_threads);
+    fflush(stdout);
+
+    while (!stop) {
+        int njobs = 0;
+
+        collect(listen_fd, clients, jobs, &njobs, -1);
+        if (njobs == 0)
+            continue;
+
+        /* give the requests still on their way a chance to join the
+           round */
+        if (wait_us > 0 && njobs < MAX_JOBS) {
+            double until = now() + wait_us * 1e-6;
+            double left;
+            while (njobs < MAX_JOBS && (left = until - now()) > 0)
+                collect(listen_fd, clients, jobs, &njobs,
+                        (int)(left * 1e3) + 1);
+        }
+
+        run_round(clients, jobs, njobs, num_threads, batch_max, scratch,
+                  &arena);
+        ++rounds;
+        served += njobs;
+        for (int j = 0; j < njobs; ++j)
+            batched += jobs[j].reply.batch > 1;
+    }
+
+    printf("Served %ld jobs in %ld rounds, %ld of them batched\n", served,
+           rounds, batched);
+    for (int s = 0; s < MAX_CLIENTS; ++s)
+        if (clients[s].fd >= 0)
+            close(clients[s].fd);
+    close(listen_fd);
+    unlink(path);
+    pool_shutdown();
+    wave_arena_release(&arena);
+    free(scratch);
+    return EXIT_SUCCESS;
+}
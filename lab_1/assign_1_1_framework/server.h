@@ -0,0 +1,22 @@
+/*
+ * server.h
+ *
+ * Daemon mode of assign1_1: `assign1_1 --serve=PATH num_threads' keeps
+ * the worker pool and the buffer arena warm and runs the jobs that
+ * clients send over the Unix socket at PATH (wire format in
+ * wave_proto.h). The requests that arrive together are run in one round:
+ * small jobs of the same size and length go through simulate_batch() as
+ * one ensemble, the others through the wave_ctx API on the parked
+ * workers, one after another.
+ *
+ * WAVE_SERVE_BATCH sets the largest i_max that is batched (default 4096,
+ * 0 turns batching off), WAVE_SERVE_WAIT the microseconds a round waits
+ * for more requests after the first (default 0), WAVE_SERVE_TIMEOUT the
+ * milliseconds a reply waits for its client to read before the client is
+ * dropped (default 1000).
+ */
+
+#pragma once
+
+/* Serves until SIGINT or SIGTERM. Returns the exit status. */
+int wave_serve(const char *path, int num_threads);
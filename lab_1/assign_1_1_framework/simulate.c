@@ -6,23 +6,139 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <time.h>
 
+#include "affinity.h"
+#include "backend.h"
+#include "barrier.h"
+#include "coeff.h"
+#include "partition.h"
+#include "pool.h"
+#include "precision.h"
+#include "reduce.h"
 #include "simulate.h"
+#include "trapezoid.h"
+#include "wave_kernels.h"
+#include "window.h"
 
 
 /* Add any global variables you may need. */
-#define C_CONST 0.15 // Mentioned in the task
+
+/* Temporal blocking: rough cost of one barrier expressed in cell updates.
+   The auto depth balances redundant ghost work (~k per step) against the
+   barrier cost amortized over k steps (~TB_BARRIER_CELLS / k). */
+#define TB_BARRIER_CELLS 4096
+
+/*
+ * Per-thread timing of the barrier solver, compiled in with -DWAVE_PROFILE
+ * (make PROFILE=1). Without it the PROF_* macros expand to nothing and the
+ * workers carry no timing code at all.
+ */
+#ifdef WAVE_PROFILE
+static inline long long prof_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#define PROF_START(v)      long long v = prof_now()
+#define PROF_ADD(acc, v)   do { long long now_ = prof_now(); \
+                                (acc) += now_ - (v); (v) = now_; } while (0)
+#else
+#define PROF_START(v)      do { } while (0)
+#define PROF_ADD(acc, v)   do { } while (0)
+#endif
+
+/* Neighbour sync: spins on a neighbour's step counter before yielding. */
+#define NB_SPIN 1000
+
+/* completed-step counter, one cache line per thread */
+typedef struct {
+    atomic_int done;
+    char pad[64 - sizeof(atomic_int)];
+} step_counter_t;
+
+/* per-thread partial sums of the in-situ reductions, one cache line each */
+typedef struct {
+    wave_sums_t sums;
+    char pad[64 - sizeof(wave_sums_t)];
+} sums_slot_t;
+
+/* Work stealing: default chunk of points, small enough that a chunk of all
+   three arrays stays in L2. Override with WAVE_CHUNK. */
+#define WS_CHUNK 4096
+
+/* Per-thread chunk deque. The chunks of a step form a contiguous index range
+   [head, tail) packed into one word: the owner takes from the head, thieves
+   take from the tail, and both claim with a CAS. */
+typedef struct {
+    _Atomic unsigned long long range;
+    char pad[64 - sizeof(unsigned long long)];
+} chunk_deque_t;
 
 /* shared state across threads */
 typedef struct {
     int i_max;
-    int t_max;
+    int t_max;         /* steps of the current wave_step() call */
+    int t0;            /* steps taken by earlier calls */
     int nthreads;
+    wave_kernel_t kernel;   /* stencil kernel (see wave_kernels.h) */
+
+    /* spatially varying c (WAVE_COEFF, barrier solver only): coef[i]
+       replaces C_CONST and ckernel replaces kernel; NULL when uniform */
+    const double *coef;
+    wave_kernel_coef_t ckernel;
+
+    /* fourth-order stencil (WAVE_ORDER=4, barrier solver only): replaces
+       kernel when set; reach is how far a step spreads the wave */
+    wave_kernel4_t kernel4;
+    int reach;
+
     double *old;
     double *cur;
     double *next;
-    pthread_barrier_t barrier;
+    spin_barrier_t barrier;
+
+    /* active window of the step being computed (see window.h); the
+       barrier solver splits it anew over the threads every step */
+    int lo;
+    int hi;
+
+    /* temporal blocking (WAVE_TBLOCK): block depth and published edge strips */
+    int k;
+    double *strips;
+    double *res_old;   /* where the final t-1 / t generations must end up */
+    double *res_cur;
+
+    /* neighbour sync (WAVE_SYNC=neighbor): generation t lives in
+       bufs[(t + 1) % nbufs], every thread publishes its completed steps */
+    double *bufs[3];
+    int nbufs;         /* 3, or 2 when next overwrites old in place */
+    step_counter_t *steps;
+
+    /* reduced precision (WAVE_PRECISION): float copies of bufs[] */
+    wave_precision_t prec;
+    float *fbufs[3];
+    wave_kernel_f_t fkernel;
+
+    /* work stealing (WAVE_SCHED=steal): deques[parity * nthreads + tid] */
+    int chunk;
+    int nchunks;
+    chunk_deque_t *deques;
+
+    /* cache-oblivious bands (WAVE_SCHED=trap): steps per band */
+    int band;
+
+    /* in-situ reductions (WAVE_REDUCE, barrier solver only): slots[tid]
+       are combined by thread 0 after the compute barrier */
+    wave_series_t series;
+    wave_kernel_reduce_t rkernel;
+    sums_slot_t *slots;
 } shared_t;
 
 /* per-thread arguments */
@@ -31,17 +147,46 @@ typedef struct {
     int tid;
     int start; 
     int end;   
+    int sense;  /* local sense for the spin barrier */
+    long chunks;  /* work stealing statistics */
+    long steals;
+#ifdef WAVE_PROFILE
+    long long compute_ns;   /* in the stencil kernel */
+    long long wait_ns[2];   /* at the barrier after compute / rotation */
+    long long serial_ns;    /* thread 0's boundary and rotation section */
+#endif
 } thr_arg_t;
 
+/* Edge strips a thread publishes after each block: [parity][side][level][k].
+   Side 0 holds the first k owned cells, side 1 the last k. Level 0 is the
+   older generation, level 1 the newer one. */
+static inline double *strip(const shared_t *S, int tid, int parity, int side,
+        int level)
+{
+    return S->strips + ((((size_t)tid * 2 + parity) * 2 + side) * 2 + level)
+                       * (size_t)S->k;
+}
+
+
+/* per-thread arguments of the first-touch initialization */
+typedef struct {
+    int tid;
+    int i_max;
+    int nthreads;
+    double *arrays[3];
+    int cpu;     /* filled in by the thread */
+    int node;
+} touch_arg_t;
+
 
 /* Add any functions you may need (like a worker) here. */
 
-static inline void compute_range(double *restrict next, const double *restrict cur, const double *restrict old, int i_begin, int i_end)
+/* clamp thread count to available work */
+static int clamp_threads(int i_max, int num_cpus)
 {
-    for (int i = i_begin; i <= i_end; ++i) {
-        next[i] = 2.0 * cur[i] - old[i]
-                + C_CONST * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
-    }
+    int interior = (i_max >= 2) ? (i_max - 2) : 0;
+    if (interior == 0) return 1;
+    return (num_cpus > interior) ? interior : num_cpus;
 }
 
 static void *worker(void *arg_void)
@@ -49,33 +194,869 @@ static void *worker(void *arg_void)
     thr_arg_t *A = (thr_arg_t *)arg_void;
     shared_t *S = A->S;
 
+    affinity_pin(A->tid);
+
     for (int t = 0; t < S->t_max; ++t) {
-        /* phase 1: compute this thread's slice of next[] */
-        if (A->start <= A->end) {
-            compute_range(S->next, S->cur, S->old, A->start, A->end);
+        int start, end;
+        PROF_START(t0);
+
+        /* phase 1: compute this thread's slice of the window of next[] */
+        wave_partition_range(S->lo, S->hi, S->nthreads, A->tid, &start, &end);
+        if (wave_series_due(&S->series, S->t0 + t)) {
+            /* the reducing kernel sums the gradient pairs (i, i+1) of its
+               points; the first slice also takes the pair (lo-1, lo) */
+            wave_sums_t *acc = &S->slots[A->tid].sums;
+            *acc = (wave_sums_t){ 0.0, 0.0, 0.0, 0.0 };
+            if (start <= end) {
+                S->rkernel(S->next, S->cur, S->old, start, end, acc);
+                if (start == S->lo) {
+                    double g = S->cur[start] - S->cur[start - 1];
+                    acc->grad += g * g;
+                }
+            }
+        } else if (start <= end && S->coef) {
+            S->ckernel(S->next, S->cur, S->old, S->coef, start, end);
+        } else if (start <= end && S->kernel4) {
+            S->kernel4(S->next, S->cur, S->old, S->i_max, start, end);
+        } else if (start <= end) {
+            S->kernel(S->next, S->cur, S->old, start, end);
         }
+        PROF_ADD(A->compute_ns, t0);
 
         /* wait for all threads to finish writing next[] */
-        pthread_barrier_wait(&S->barrier);
+        spin_barrier_wait(&S->barrier, &A->sense);
+        PROF_ADD(A->wait_ns[0], t0);
 
-        /* single-thread section: fix boundaries and rotate buffers */
+        /* single-thread section: fix boundaries, rotate buffers and widen
+           the window */
         if (A->tid == 0) {
             S->next[0] = 0.0;
             S->next[S->i_max - 1] = 0.0;
 
+            if (wave_series_due(&S->series, S->t0 + t)) {
+                wave_sums_t sum = S->slots[0].sums;
+                for (int tid = 1; tid < S->nthreads; ++tid)
+                    wave_sums_merge(&sum, &S->slots[tid].sums);
+                wave_series_add(&S->series, S->t0 + t, &sum);
+            }
+
             double *tmp = S->old;
             S->old  = S->cur;
             S->cur  = S->next;
-            S->next = tmp;
+            S->next = (S->nbufs == 2) ? S->old : tmp;
+
+            wave_window_grow_by(S->i_max, &S->lo, &S->hi, S->reach);
+            PROF_ADD(A->serial_ns, t0);
+        }
+
+        /* ensure everyone sees the rotated pointers and window */
+        spin_barrier_wait(&S->barrier, &A->sense);
+        PROF_ADD(A->wait_ns[1], t0);
+    }
+
+    return NULL;
+}
+
+/*
+ * Temporal-blocking worker. Every thread keeps a private copy of its slice
+ * widened by k ghost cells on both sides and advances it up to k steps on
+ * its own, recomputing the shrinking ghost triangles redundantly. Between
+ * blocks only the outermost k cells of each slice are exchanged, through
+ * strips double-buffered by block parity, so a single barrier per block is
+ * enough. The arithmetic per cell is identical to S->kernel, so the
+ * result matches the step-by-step solver bit for bit.
+ */
+static void *worker_tblock(void *arg_void)
+{
+    thr_arg_t *A = (thr_arg_t *)arg_void;
+    shared_t *S = A->S;
+    const int i_max = S->i_max;
+    const int k = S->k;
+    const int T = S->nthreads;
+    const int tid = A->tid;
+
+    affinity_pin(tid);
+
+    /* private window [lo, hi] in global indices; local index = g - lo */
+    int lo = A->start - k;
+    int hi = A->end + k;
+    if (lo < 0) lo = 0;
+    if (hi > i_max - 1) hi = i_max - 1;
+    int n = hi - lo + 1;
+
+    double *buf = (double *)malloc(sizeof(double) * 3 * (size_t)n);
+    if (!buf) {
+        fprintf(stderr, "Thread %d: failed to allocate block buffers\n", tid);
+        exit(EXIT_FAILURE);
+    }
+    double *po = buf, *pc = buf + n, *pn = buf + 2 * (size_t)n;
+
+    memcpy(po, S->old + lo, sizeof(double) * n);
+    memcpy(pc, S->cur + lo, sizeof(double) * n);
+
+    for (int t0 = 0, b = 0; t0 < S->t_max; t0 += k, ++b) {
+        int kk = (S->t_max - t0 < k) ? (S->t_max - t0) : k;
+
+        /* pull neighbour edges published after the previous block */
+        if (b > 0) {
+            int p = (b - 1) & 1;
+            if (tid > 0) {
+                int g = A->start - kk;
+                memcpy(po + (g - lo), strip(S, tid - 1, p, 1, 0) + (k - kk),
+                       sizeof(double) * kk);
+                memcpy(pc + (g - lo), strip(S, tid - 1, p, 1, 1) + (k - kk),
+                       sizeof(double) * kk);
+            }
+            if (tid < T - 1) {
+                int g = A->end + 1;
+                memcpy(po + (g - lo), strip(S, tid + 1, p, 0, 0),
+                       sizeof(double) * kk);
+                memcpy(pc + (g - lo), strip(S, tid + 1, p, 0, 1),
+                       sizeof(double) * kk);
+            }
+        }
+
+        for (int s = 1; s <= kk; ++s) {
+            int g_begin = A->start - (kk - s);
+            int g_end   = A->end + (kk - s);
+            if (g_begin < 1) g_begin = 1;
+            if (g_end > i_max - 2) g_end = i_max - 2;
+
+            S->kernel(pn, pc, po, g_begin - lo, g_end - lo);
+
+            if (lo == 0) pn[0] = 0.0;
+            if (hi == i_max - 1) pn[hi - lo] = 0.0;
+
+            double *tmp = po;
+            po = pc;
+            pc = pn;
+            pn = tmp;
         }
 
-        /* ensure everyone sees the rotated pointers */
-        pthread_barrier_wait(&S->barrier);
+        if (T > 1 && t0 + kk < S->t_max) {
+            int p = b & 1;
+            int first = A->start - lo;
+            int last  = A->end - k + 1 - lo;
+            memcpy(strip(S, tid, p, 0, 0), po + first, sizeof(double) * k);
+            memcpy(strip(S, tid, p, 0, 1), pc + first, sizeof(double) * k);
+            memcpy(strip(S, tid, p, 1, 0), po + last, sizeof(double) * k);
+            memcpy(strip(S, tid, p, 1, 1), pc + last, sizeof(double) * k);
+        }
+
+        /* the first block may still be reading the caller's arrays, which
+           double as the output buffers, so the last block syncs as well */
+        spin_barrier_wait(&S->barrier, &A->sense);
+    }
+
+    /* write back the owned slice (and the fixed ends) of the last two
+       generations into the buffers the step-by-step solver would use */
+    int w_begin = (tid == 0) ? 0 : A->start;
+    int w_end   = (tid == T - 1) ? i_max - 1 : A->end;
+    memcpy(S->res_old + w_begin, po + (w_begin - lo),
+           sizeof(double) * (w_end - w_begin + 1));
+    memcpy(S->res_cur + w_begin, pc + (w_begin - lo),
+           sizeof(double) * (w_end - w_begin + 1));
+
+    free(buf);
+    return NULL;
+}
+
+/* Waits until a neighbour has completed at least t steps. */
+static inline void wait_step(atomic_int *done, int t)
+{
+    int spins = 0;
+    while (atomic_load_explicit(done, memory_order_acquire) < t) {
+        if (++spins < NB_SPIN) cpu_relax();
+        else sched_yield();
+    }
+}
+
+/*
+ * Neighbour-synchronized worker. Instead of two global barriers per step a
+ * thread only waits for its left and right neighbour to have completed the
+ * previous step: their edge cells of generation t are then written, and
+ * since they are done reading generation t-2 as well, it can be overwritten
+ * in place. Buffers are picked by t % nbufs, so no shared pointer rotation
+ * is needed. Threads drift apart by at most their distance in steps.
+ */
+static void *worker_neighbor(void *arg_void)
+{
+    thr_arg_t *A = (thr_arg_t *)arg_void;
+    shared_t *S = A->S;
+    const int tid = A->tid;
+    atomic_int *left  = (tid > 0) ? &S->steps[tid - 1].done : NULL;
+    atomic_int *right = (tid < S->nthreads - 1) ? &S->steps[tid + 1].done
+                                                 : NULL;
+
+    affinity_pin(tid);
+
+    for (int t = 0; t < S->t_max; ++t) {
+        if (left) wait_step(left, t);
+        if (right) wait_step(right, t);
+
+        double *old  = S->bufs[t % S->nbufs];
+        double *cur  = S->bufs[(t + 1) % S->nbufs];
+        double *next = S->bufs[(t + 2) % S->nbufs];
+
+        if (A->start <= A->end) {
+            S->kernel(next, cur, old, A->start, A->end);
+        }
+        if (!left) next[0] = 0.0;
+        if (!right) next[S->i_max - 1] = 0.0;
+
+        atomic_store_explicit(&S->steps[tid].done, t + 1,
+                              memory_order_release);
+    }
+
+    return NULL;
+}
+
+/* Packs / unpacks a deque range. */
+static inline unsigned long long ws_pack(unsigned head, unsigned tail)
+{
+    return ((unsigned long long)head << 32) | tail;
+}
+
+/* Home chunks of thread tid; the same every step to keep cache affinity. */
+static inline unsigned long long ws_home(const shared_t *S, int tid)
+{
+    unsigned head = (unsigned)((long)S->nchunks * tid / S->nthreads);
+    unsigned tail = (unsigned)((long)S->nchunks * (tid + 1) / S->nthreads);
+    return ws_pack(head, tail);
+}
+
+/* Claims one chunk from the head (owner) or tail (thief) of a deque.
+   Returns the chunk index or -1 when it is empty. */
+static inline int ws_take(chunk_deque_t *d, int from_tail)
+{
+    unsigned long long r = atomic_load_explicit(&d->range,
+                                                memory_order_relaxed);
+    for (;;) {
+        unsigned head = (unsigned)(r >> 32), tail = (unsigned)r;
+        if (head >= tail)
+            return -1;
+        unsigned long long want = from_tail ? ws_pack(head, tail - 1)
+                                            : ws_pack(head + 1, tail);
+        if (atomic_compare_exchange_weak(&d->range, &r, want))
+            return (int)(from_tail ? tail - 1 : head);
+    }
+}
+
+static inline void ws_run_chunk(const shared_t *S, int c, double *next,
+        const double *cur, const double *old)
+{
+    int i_begin = 1 + c * S->chunk;
+    int i_end = i_begin + S->chunk - 1;
+    if (i_end > S->i_max - 2) i_end = S->i_max - 2;
+
+    S->kernel(next, cur, old, i_begin, i_end);
+    if (c == 0) next[0] = 0.0;
+    if (c == S->nchunks - 1) next[S->i_max - 1] = 0.0;
+}
+
+/*
+ * Work-stealing worker. Every step is cut into chunks; a thread first
+ * drains its own deque (its home chunks, front to back) and then steals
+ * single chunks from the back of the other deques, so a slow or busy core
+ * hands its remaining work to faster ones. Deques are double-buffered by
+ * step parity: while step t runs on one set, each owner already refills its
+ * deque in the other set, and buffers are picked by t % nbufs (see
+ * worker_float), so one barrier per step suffices.
+ */
+static void *worker_steal(void *arg_void)
+{
+    thr_arg_t *A = (thr_arg_t *)arg_void;
+    shared_t *S = A->S;
+    const int T = S->nthreads;
+    const int tid = A->tid;
+
+    affinity_pin(tid);
+
+    for (int t = 0; t < S->t_max; ++t) {
+        chunk_deque_t *set = S->deques + (size_t)(t & 1) * T;
+        double *old  = S->bufs[t % S->nbufs];
+        double *cur  = S->bufs[(t + 1) % S->nbufs];
+        double *next = S->bufs[(t + 2) % S->nbufs];
+        int c;
+
+        /* nobody touches the other parity until after the next barrier */
+        atomic_store_explicit(&S->deques[(size_t)((t + 1) & 1) * T + tid].range,
+                              ws_home(S, tid), memory_order_relaxed);
+
+        while ((c = ws_take(&set[tid], 0)) >= 0) {
+            ws_run_chunk(S, c, next, cur, old);
+            ++A->chunks;
+        }
+
+        for (int v = 1; v < T; ++v) {
+            chunk_deque_t *victim = &set[(tid + v) % T];
+            while ((c = ws_take(victim, 1)) >= 0) {
+                ws_run_chunk(S, c, next, cur, old);
+                ++A->chunks;
+                ++A->steals;
+            }
+        }
+
+        spin_barrier_wait(&S->barrier, &A->sense);
+    }
+
+    return NULL;
+}
+
+/*
+ * Cache-oblivious worker. Time is cut into bands of S->band steps; in each
+ * band every thread first walks the upright trapezoid over its own slice,
+ * whose sides shrink by one point per step towards the inside, and after a
+ * barrier the inverted triangle that grows over the seam with its right
+ * neighbour. Both walks recurse in space and time (see trapezoid.h), so a
+ * band touches memory about once instead of once per step, and there are
+ * two barriers per band instead of two per step.
+ */
+static void *worker_trap(void *arg_void)
+{
+    thr_arg_t *A = (thr_arg_t *)arg_void;
+    shared_t *S = A->S;
+    const int first = (A->tid == 0);
+    const int last = (A->tid == S->nthreads - 1);
+    wave_trap_t w = {
+        { S->bufs[0], S->bufs[1], S->bufs[2] }, S->nbufs, S->i_max,
+        S->kernel
+    };
+
+    affinity_pin(A->tid);
+
+    for (int t0 = 0; t0 < S->t_max; t0 += S->band) {
+        int t1 = (S->t_max - t0 < S->band) ? S->t_max : t0 + S->band;
+
+        wave_trapezoid(&w, t0, t1, A->start, first ? 0 : 1,
+                       A->end + 1, last ? 0 : -1);
+        spin_barrier_wait(&S->barrier, &A->sense);
+
+        if (!last) {
+            wave_trapezoid(&w, t0, t1, A->end + 1, -1, A->end + 1, 1);
+        }
+        spin_barrier_wait(&S->barrier, &A->sense);
+    }
+
+    return NULL;
+}
+
+/*
+ * Float-storage worker for WAVE_PRECISION=float|mixed. Each thread converts
+ * its own slice in and out, so the float arrays are first touched by their
+ * owner. Buffers are picked by t % 3 instead of rotating shared pointers,
+ * so a single barrier per step is enough.
+ */
+static void *worker_float(void *arg_void)
+{
+    thr_arg_t *A = (thr_arg_t *)arg_void;
+    shared_t *S = A->S;
+    const int first = (A->tid == 0);
+    const int last = (A->tid == S->nthreads - 1);
+    const int lo = first ? 0 : A->start;
+    const int hi = last ? S->i_max - 1 : A->end;
+
+    affinity_pin(A->tid);
+
+    for (int i = lo; i <= hi; ++i) {
+        S->fbufs[0][i] = (float)S->bufs[0][i];
+        S->fbufs[1][i] = (float)S->bufs[1][i];
+    }
+    spin_barrier_wait(&S->barrier, &A->sense);
+
+    for (int t = 0; t < S->t_max; ++t) {
+        float *old  = S->fbufs[t % 3];
+        float *cur  = S->fbufs[(t + 1) % 3];
+        float *next = S->fbufs[(t + 2) % 3];
+
+        if (A->start <= A->end) {
+            S->fkernel(next, cur, old, A->start, A->end);
+        }
+        if (first) next[0] = 0.0f;
+        if (last) next[S->i_max - 1] = 0.0f;
+
+        spin_barrier_wait(&S->barrier, &A->sense);
+    }
+
+    const float *f_old = S->fbufs[S->t_max % 3];
+    const float *f_cur = S->fbufs[(S->t_max + 1) % 3];
+    for (int i = lo; i <= hi; ++i) {
+        S->res_old[i] = f_old[i];
+        S->res_cur[i] = f_cur[i];
+    }
+
+    return NULL;
+}
+
+/*
+ * Reads the temporal blocking depth from WAVE_TBLOCK. Unset or 0 keeps the
+ * classic two-barriers-per-step solver, a positive number requests that many
+ * steps per block and "auto" picks one. The depth is capped by the smallest
+ * slice, so ghost cells only ever come from the direct neighbours.
+ */
+static int tblock_depth(int t_max, int min_len, int nthreads)
+{
+    const char *env = getenv("WAVE_TBLOCK");
+    int k;
+
+    if (!env || !*env) return 0;
+
+    if (strcmp(env, "auto") == 0) {
+        if (nthreads == 1) return t_max;
+        k = 1;
+        while ((k + 1) * (k + 1) <= TB_BARRIER_CELLS) ++k;
+        if (k > min_len / 4) k = min_len / 4;
+    } else {
+        k = atoi(env);
+        if (k <= 0) return 0;
+    }
+
+    if (k > min_len) k = min_len;
+    if (k > t_max) k = t_max;
+    if (k < 1) k = 1;
+    return k;
+}
+
+
+/*
+ * Zeroes one partition of all three arrays from the thread that will later
+ * compute on it, so the kernel places those pages on that thread's node.
+ */
+static void *touch_worker(void *arg_void)
+{
+    touch_arg_t *A = (touch_arg_t *)arg_void;
+    int start, end;
+
+    A->cpu = affinity_pin(A->tid);
+
+    wave_partition(A->i_max, A->nthreads, A->tid, &start, &end);
+    if (A->tid == 0) start = 0;
+    if (A->tid == A->nthreads - 1) end = A->i_max - 1;
+
+    for (int k = 0; k < 3; ++k) {
+        if (A->arrays[k])
+            memset(A->arrays[k] + start, 0, sizeof(double) * (end - start + 1));
     }
+    A->node = affinity_node_of(A->arrays[1] + start);
 
     return NULL;
 }
 
+/*
+ * First-touch initialization: zeroes the three freshly allocated arrays
+ * with the same threads, pinning and partition simulate() will use, and
+ * reports the CPU and NUMA node every partition ended up on.
+ */
+void simulate_first_touch(const int i_max, const int num_cpus,
+        double *old_array, double *current_array, double *next_array)
+{
+    int T = clamp_threads(i_max, num_cpus);
+    touch_arg_t *args = (touch_arg_t *)malloc(sizeof(touch_arg_t) * T);
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * T);
+
+    if (!args || !threads) {
+        fprintf(stderr, "First touch allocation failed; zeroing serially.\n");
+        free(args);
+        free(threads);
+        memset(old_array, 0, sizeof(double) * i_max);
+        memset(current_array, 0, sizeof(double) * i_max);
+        if (next_array)
+            memset(next_array, 0, sizeof(double) * i_max);
+        return;
+    }
+
+    for (int tid = 0; tid < T; ++tid) {
+        args[tid].tid = tid;
+        args[tid].i_max = i_max;
+        args[tid].nthreads = T;
+        args[tid].arrays[0] = old_array;
+        args[tid].arrays[1] = current_array;
+        args[tid].arrays[2] = next_array;
+    }
+
+    if (pool_run(touch_worker, args, sizeof(touch_arg_t), T) != 0) {
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_create(&threads[tid], NULL, touch_worker, &args[tid]);
+        }
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_join(threads[tid], NULL);
+        }
+    }
+
+    for (int tid = 0; tid < T; ++tid) {
+        int start, end;
+        wave_partition(i_max, T, tid, &start, &end);
+        fprintf(stderr, "Partition %d [%d, %d]: cpu %d, node %d\n",
+                tid, start, end, args[tid].cpu, args[tid].node);
+    }
+
+    free(args);
+    free(threads);
+}
+
+
+#ifdef WAVE_PROFILE
+/*
+ * Prints the per-thread timings of the barrier-solver steps of a context,
+ * t_max of them over all its wave_step() calls, and the load imbalance of
+ * the compute phase (max / mean over the threads; 1.0 is perfect balance).
+ * WAVE_PROFILE_CSV=<file> also appends one row per thread.
+ */
+static void prof_report(const shared_t *S, const thr_arg_t *args, int T,
+        long t_max)
+{
+    const char *csv = getenv("WAVE_PROFILE_CSV");
+    double sum = 0.0, wait = 0.0, total = 0.0;
+    int worst = 0;
+    FILE *fp = NULL;
+
+    if (csv && *csv) {
+        if (!(fp = fopen(csv, "a")))
+            fprintf(stderr, "Cannot open %s for the profile.\n", csv);
+        else if (ftell(fp) == 0)
+            fprintf(fp, "i_max,t_max,threads,tid,compute_s,wait_compute_s,"
+                    "serial_s,wait_rotate_s\n");
+    }
+
+    for (int tid = 0; tid < T; ++tid) {
+        const thr_arg_t *A = &args[tid];
+        double c = A->compute_ns * 1e-9, s = A->serial_ns * 1e-9;
+        double w0 = A->wait_ns[0] * 1e-9, w1 = A->wait_ns[1] * 1e-9;
+
+        fprintf(stderr, "Thread %d: compute %.6f s, barrier wait %.6f s + "
+                "%.6f s, serial %.6f s\n", tid, c, w0, w1, s);
+        if (fp)
+            fprintf(fp, "%d,%ld,%d,%d,%.9f,%.9f,%.9f,%.9f\n", S->i_max,
+                    t_max, T, tid, c, w0, s, w1);
+        if (A->compute_ns > args[worst].compute_ns) worst = tid;
+        sum += c;
+        wait += w0 + w1;
+        total += c + w0 + w1 + s;
+    }
+
+    fprintf(stderr, "Load imbalance: compute max/mean %.3f (worst thread %d), "
+            "barrier wait %.1f%% of thread time\n",
+            sum > 0.0 ? args[worst].compute_ns * 1e-9 / (sum / T) : 1.0,
+            worst, total > 0.0 ? 100.0 * wait / total : 0.0);
+    if (fp) fclose(fp);
+}
+#endif
+
+/* Solver state that outlives a single wave_step() call. */
+struct wave_ctx {
+    shared_t S;
+    int T;
+    thr_arg_t *args;
+    pthread_t *threads;
+    pool_fn_t fn;          /* worker picked at creation */
+    int tblock;            /* WAVE_TBLOCK requested */
+    int max_band;          /* trapezoid band height before capping by n */
+    size_t strips_k;       /* depth the strips are allocated for */
+    int owns_pool;         /* pool_init() was ours */
+    int reported;
+    long steps;
+    long worker_steps;     /* of them run by the barrier solver */
+    double *bufs[3];       /* generation t-1, t and the spare buffer */
+};
+
+/* Allocates the context and picks the solver mode; see wave_ctx.h. With
+   persistent set the workers are kept parked in the pool between calls. */
+static wave_ctx_t *ctx_create(int i_max, int num_cpus, double *old_array,
+        double *current_array, double *next_array, int persistent)
+{
+    wave_ctx_t *ctx = (wave_ctx_t *)calloc(1, sizeof(wave_ctx_t));
+    if (!ctx) return NULL;
+
+    int interior = (i_max >= 2) ? (i_max - 2) : 0;
+    int T = clamp_threads(i_max, num_cpus);
+    shared_t *S = &ctx->S;
+
+    ctx->T = T;
+    ctx->bufs[0] = old_array;
+    ctx->bufs[1] = current_array;
+    ctx->bufs[2] = next_array;
+
+    S->i_max = i_max;
+    S->nthreads = T;
+    S->kernel = wave_kernel_select();
+    S->nbufs = next_array ? 3 : 2;
+    S->series.every = 0;
+
+    /* a varying c and the fourth-order stencil need the barrier solver;
+       every other mode below checks for them and stays off */
+    S->coef = wave_coeff(i_max);
+    if (S->coef)
+        S->ckernel = wave_kernel_coef();
+    if (wave_order() == 4 && S->coef)
+        fprintf(stderr, "Fourth order needs a uniform c; using second "
+                "order.\n");
+    else if (wave_order() == 4)
+        S->kernel4 = wave_kernel4();
+    S->reach = S->kernel4 ? 2 : 1;
+    const int plain = !S->coef && !S->kernel4;
+
+    S->prec = wave_precision();
+    if (!plain && S->prec != WAVE_DOUBLE) {
+        fprintf(stderr, "Reduced precision needs a uniform c and the "
+                "second-order stencil; using double.\n");
+        S->prec = WAVE_DOUBLE;
+    }
+    /* the float arrays come on top of the caller's doubles: half as many
+       bytes streamed per step, half as many more held */
+    if (S->prec != WAVE_DOUBLE) {
+        float *f = (float *)malloc(sizeof(float) * 3 * (size_t)i_max);
+        if (!f) {
+            fprintf(stderr, "Float buffer allocation failed; using double.\n");
+            S->prec = WAVE_DOUBLE;
+        } else {
+            S->fbufs[0] = f;
+            S->fbufs[1] = f + i_max;
+            S->fbufs[2] = f + 2 * (size_t)i_max;
+            S->fkernel = wave_kernel_f_select(S->prec);
+        }
+    }
+
+    const char *sync = getenv("WAVE_SYNC");
+    if (S->prec == WAVE_DOUBLE && plain && sync && (strcmp(sync, "neighbor") == 0
+                 || strcmp(sync, "neighbour") == 0)) {
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(step_counter_t) * T) != 0)
+            fprintf(stderr, "Counter allocation failed; using barriers.\n");
+        else
+            S->steps = (step_counter_t *)mem;
+    }
+
+    const char *sched = getenv("WAVE_SCHED");
+    if (S->prec == WAVE_DOUBLE && plain && !S->steps && interior > 0
+            && sched && strcmp(sched, "steal") == 0) {
+        const char *chunk = getenv("WAVE_CHUNK");
+        void *mem = NULL;
+
+        S->chunk = (chunk && atoi(chunk) > 0) ? atoi(chunk) : WS_CHUNK;
+        S->nchunks = (interior + S->chunk - 1) / S->chunk;
+        if (posix_memalign(&mem, 64, sizeof(chunk_deque_t) * 2 * T) != 0)
+            fprintf(stderr, "Deque allocation failed; using static split.\n");
+        else
+            S->deques = (chunk_deque_t *)mem;
+    }
+
+    if (S->prec == WAVE_DOUBLE && plain && !S->steps && interior > 0
+            && sched && strcmp(sched, "trap") == 0) {
+        /* the upright trapezoids must not shrink to nothing within a band */
+        int start, end;
+        wave_partition(i_max, T, T - 1, &start, &end);
+        ctx->max_band = (T == 1) ? INT_MAX : (end - start + 1) / 2;
+        if (ctx->max_band < 1) ctx->max_band = 1;
+    }
+
+    ctx->tblock = !S->fbufs[0] && plain && !S->steps && !S->deques
+                  && ctx->max_band == 0 && tblock_depth(1, interior / T, T) > 0;
+
+    /* temporal blocking and the trapezoids work in cache-resident pieces
+       and the in-place update already skips the extra read of next;
+       everything else sweeps the full arrays and may want streaming
+       stores */
+    if (!ctx->tblock && !S->fbufs[0] && S->nbufs == 3 && ctx->max_band == 0)
+        S->kernel = wave_kernel_for(3 * sizeof(double) * (size_t)i_max);
+
+    ctx->fn = S->fbufs[0] ? worker_float
+            : S->steps ? worker_neighbor
+            : S->deques ? worker_steal
+            : ctx->max_band > 0 ? worker_trap
+            : ctx->tblock ? worker_tblock : worker;
+
+    /* the barrier solver skips the provably zero parts of the wave; the
+       next buffer must then hold zeros where the window has not reached */
+    S->lo = 1;
+    S->hi = i_max - 2;
+    if (ctx->fn == worker) {
+        wave_window(old_array, current_array, i_max, &S->lo, &S->hi);
+        wave_window_grow_by(i_max, &S->lo, &S->hi, S->reach);
+        if (S->nbufs == 3 && (S->lo > 1 || S->hi < i_max - 2))
+            wave_window_clear(next_array, i_max, S->lo, S->hi);
+    }
+
+    /* the reductions ride on the barrier solver's synchronization */
+    if (ctx->fn == worker && plain && wave_series_init(&S->series)) {
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(sums_slot_t) * T) != 0) {
+            fprintf(stderr, "Reduction slot allocation failed; "
+                    "reductions off.\n");
+            S->series.every = 0;
+        } else {
+            S->slots = (sums_slot_t *)mem;
+            S->rkernel = wave_kernel_reduce();
+        }
+    } else if ((ctx->fn != worker || !plain) && getenv("WAVE_REDUCE")
+            && atoi(getenv("WAVE_REDUCE")) > 0) {
+        fprintf(stderr, "Reductions need the barrier solver, a uniform c "
+                "and the second-order stencil; ignoring WAVE_REDUCE.\n");
+    }
+
+    ctx->threads = (pthread_t *)malloc(sizeof(pthread_t) * T);
+    ctx->args    = (thr_arg_t *)calloc(T, sizeof(thr_arg_t));
+    if (!ctx->threads || !ctx->args
+            || spin_barrier_init(&S->barrier, T) != 0) {
+        free(ctx->threads);
+        free(ctx->args);
+        free(S->steps);
+        free(S->fbufs[0]);
+        free(S->deques);
+        free(S->slots);
+        free(ctx);
+        return NULL;
+    }
+
+    /* near-equal contiguous partition of [1 .. i_max-2]; the barrier
+       senses carry over from call to call with the barrier itself */
+    for (int tid = 0; tid < T; ++tid) {
+        ctx->args[tid].S     = S;
+        ctx->args[tid].tid   = tid;
+        wave_partition(i_max, T, tid, &ctx->args[tid].start,
+                       &ctx->args[tid].end);
+        ctx->args[tid].sense = 0;
+    }
+
+    /* park the workers between calls, unless a pool is already running */
+    if (persistent && pool_init(T) == 0)
+        ctx->owns_pool = 1;
+
+    return ctx;
+}
+
+wave_ctx_t *wave_ctx_create(int i_max, int num_threads, double *old_array,
+        double *current_array, double *next_array)
+{
+    return ctx_create(i_max, num_threads, old_array, current_array,
+                      next_array, 1);
+}
+
+int wave_step(wave_ctx_t *ctx, int n)
+{
+    if (!ctx) return -1;
+    if (n <= 0) return 0;
+
+    shared_t *S = &ctx->S;
+    const int T = ctx->T;
+    const int i_max = S->i_max;
+    pool_fn_t fn = ctx->fn;
+
+    /* step t of this call reads bufs[t % nbufs] and bufs[(t + 1) % nbufs] */
+    S->t_max = n;
+    S->t0 = (int)ctx->steps;
+    for (int j = 0; j < 3; ++j)
+        S->bufs[j] = ctx->bufs[j];
+    S->old  = S->bufs[0];
+    S->cur  = S->bufs[1];
+    S->next = (S->nbufs == 3) ? S->bufs[2] : S->bufs[0];
+    S->res_old = S->bufs[n % S->nbufs];
+    S->res_cur = S->bufs[(n + 1) % S->nbufs];
+
+    if (S->steps) {
+        for (int tid = 0; tid < T; ++tid)
+            atomic_init(&S->steps[tid].done, 0);
+    }
+    if (S->deques) {
+        for (int tid = 0; tid < T; ++tid) {
+            atomic_init(&S->deques[tid].range, ws_home(S, tid));
+            atomic_init(&S->deques[T + tid].range, 0);
+        }
+    }
+    S->band = (ctx->max_band > n) ? n : ctx->max_band;
+    if (S->band > 0 && !ctx->reported) {
+        fprintf(stderr, "Trapezoid bands: %d steps, %d barriers (was %d)\n",
+                S->band, 2 * ((n + S->band - 1) / S->band), 2 * n);
+    }
+
+    /* the block depth depends on the steps of this call; the strips only
+       ever grow */
+    S->k = 0;
+    if (ctx->tblock) {
+        S->k = tblock_depth(n, (i_max - 2) / T, T);
+        if (T > 1 && (size_t)S->k > ctx->strips_k) {
+            double *strips = (double *)realloc(S->strips,
+                    sizeof(double) * 8 * (size_t)T * S->k);
+            if (!strips) {
+                fprintf(stderr, "Strip allocation failed; "
+                        "using barrier solver.\n");
+                S->k = 0;
+            } else {
+                S->strips = strips;
+                ctx->strips_k = S->k;
+            }
+        }
+        if (S->k > 0 && T > 1 && !ctx->reported) {
+            int blocks = (n + S->k - 1) / S->k;
+            fprintf(stderr, "Temporal blocking: k=%d, %d barriers (was %d)\n",
+                    S->k, blocks, 2 * n);
+        }
+        if (S->k == 0)
+            fn = worker;
+    }
+    ctx->reported = 1;
+
+    /* reuse the parked pool workers if there are any */
+    if (pool_run(fn, ctx->args, sizeof(thr_arg_t), T) != 0) {
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_create(&ctx->threads[tid], NULL, fn, &ctx->args[tid]);
+        }
+
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_join(ctx->threads[tid], NULL);
+        }
+    }
+
+    /* the statistics add up over the calls and are reported once, by
+       wave_destroy() */
+    if (fn == worker)
+        ctx->worker_steps += n;
+
+    for (int j = 0; j < S->nbufs; ++j)
+        ctx->bufs[j] = S->bufs[(n + j) % S->nbufs];
+    ctx->steps += n;
+    return 0;
+}
+
+const double *wave_view(const wave_ctx_t *ctx, const double **prev)
+{
+    if (prev) *prev = ctx->bufs[0];
+    return ctx->bufs[1];
+}
+
+void wave_destroy(wave_ctx_t *ctx)
+{
+    if (!ctx) return;
+
+#ifdef WAVE_PROFILE
+    if (ctx->worker_steps)
+        prof_report(&ctx->S, ctx->args, ctx->T, ctx->worker_steps);
+#endif
+
+    if (ctx->S.deques && ctx->steps) {
+        long steals = 0;
+        for (int tid = 0; tid < ctx->T; ++tid) {
+            fprintf(stderr, "Thread %d: %ld chunks, %ld stolen\n",
+                    tid, ctx->args[tid].chunks, ctx->args[tid].steals);
+            steals += ctx->args[tid].steals;
+        }
+        fprintf(stderr, "Work stealing: %d chunks of %d points per step, "
+                "%ld steals in %ld steps\n", ctx->S.nchunks, ctx->S.chunk,
+                steals, ctx->steps);
+    }
+
+    if (ctx->owns_pool)
+        pool_shutdown();
+    wave_series_finish(&ctx->S.series);
+    spin_barrier_destroy(&ctx->S.barrier);
+    free(ctx->threads);
+    free(ctx->args);
+    free(ctx->S.strips);
+    free(ctx->S.steps);
+    free(ctx->S.fbufs[0]);
+    free(ctx->S.deques);
+    free(ctx->S.slots);
+    free(ctx);
+}
 
 /*
  * Executes the entire simulation.
@@ -94,72 +1075,229 @@ double *simulate(const int i_max, const int t_max, const int num_cpus,
 {
     if (t_max <= 0) return current_array;
 
-    int interior = (i_max >= 2) ? (i_max - 2) : 0;
+    wave_ctx_t *ctx = ctx_create(i_max, num_cpus, old_array, current_array,
+                                 next_array, 0);
+    if (!ctx) {
+        fprintf(stderr, "Thread allocation failed; falling back to sequential.\n");
+        double *bufs[3] = { old_array, current_array, next_array };
+        const int nbufs = next_array ? 3 : 2;
+        /* the same stencil as the threads would have run, in double */
+        const double *coef = wave_coeff(i_max);
+        wave_kernel_t kernel = wave_kernel_select();
+        wave_kernel_coef_t ckernel = coef ? wave_kernel_coef() : NULL;
+        wave_kernel4_t kernel4 = (!coef && wave_order() == 4)
+                               ? wave_kernel4() : NULL;
 
-    /* clamp thread count to available work */
-    int T = num_cpus;
-    if (interior == 0) T = 1;
-    else if (T > interior) T = interior;
+        for (int t = 0; t < t_max; ++t) {
+            double *old  = bufs[t % nbufs];
+            double *cur  = bufs[(t + 1) % nbufs];
+            double *next = bufs[(t + 2) % nbufs];
+            if (ckernel)
+                ckernel(next, cur, old, coef, 1, i_max - 2);
+            else if (kernel4)
+                kernel4(next, cur, old, i_max, 1, i_max - 2);
+            else
+                kernel(next, cur, old, 1, i_max - 2);
+            next[0] = 0.0;
+            next[i_max - 1] = 0.0;
+        }
+        return bufs[(t_max + 1) % nbufs];
+    }
 
-    shared_t S;
-    S.i_max = i_max;
-    S.t_max = t_max;
-    S.nthreads = T;
-    S.old  = old_array;
-    S.cur  = current_array;
-    S.next = next_array;
+    wave_step(ctx, t_max);
+    double *res = ctx->bufs[1];
+    wave_destroy(ctx);
+    return res;
+}
 
-    pthread_barrier_init(&S.barrier, NULL, T);
+/*
+ * Batched ensembles. The strings are independent, so every thread claims a
+ * block of BATCH_WIDTH strings at a time and runs all t_max steps of it on
+ * its own: there is no barrier between steps, only the block counter. The
+ * block is first packed into a private tile with its strings side by side,
+ * one 64-byte line per point, which vectorizes across the strings whatever
+ * the caller's layout and keeps large power-of-two strides between the
+ * points of a string from thrashing the cache sets.
+ */
+#define BATCH_WIDTH 8
 
-    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * T);
-    thr_arg_t *args    = (thr_arg_t *)malloc(sizeof(thr_arg_t) * T);
-    if (!threads || !args) {
-        fprintf(stderr, "Thread allocation failed; falling back to sequential.\n");
-        if (threads) free(threads);
-        if (args) free(args);
-        /* sequential fallback */
-        for (int t = 0; t < t_max; ++t) {
-            for (int i = 1; i < i_max - 1; ++i) {
-                next_array[i] = 2.0 * current_array[i] - old_array[i]
-                              + C_CONST * (current_array[i - 1]
-                                           - 2.0 * current_array[i]
-                                           + current_array[i + 1]);
+typedef struct {
+    int i_max;
+    int t_max;
+    int nstrings;
+    int nblocks;
+    size_t point_stride;    /* distance between points of a string */
+    size_t string_stride;   /* distance between strings */
+    double *bufs[3];
+    int nbufs;
+    wave_kernel_batch_t kernel;
+    atomic_int next_block;
+} batch_t;
+
+typedef struct {
+    batch_t *B;
+    int tid;
+    double *tile;   /* 3 generations of i_max * BATCH_WIDTH */
+} batch_arg_t;
+
+/* Copies strings [s0, s0 + width) of a between the caller's layout and the
+   tile layout. */
+static void batch_pack(const batch_t *B, double *tile, double *a, int s0,
+        int width, int unpack)
+{
+    for (int i = 0; i < B->i_max; ++i) {
+        double *row = a + i * B->point_stride + s0 * B->string_stride;
+        for (int c = 0; c < width; ++c) {
+            if (unpack)
+                row[c * B->string_stride] = tile[i * BATCH_WIDTH + c];
+            else
+                tile[i * BATCH_WIDTH + c] = row[c * B->string_stride];
+        }
+    }
+}
+
+/* All t_max steps of strings [s0, s0 + width). */
+static void batch_block(const batch_t *B, double *tile, int s0, int width)
+{
+    const size_t gen = (size_t)B->i_max * BATCH_WIDTH;
+    const size_t last = (size_t)(B->i_max - 1) * BATCH_WIDTH;
+    double *t_bufs[3] = { tile, tile + gen, tile + 2 * gen };
+
+    batch_pack(B, t_bufs[0], B->bufs[0], s0, width, 0);
+    batch_pack(B, t_bufs[1], B->bufs[1], s0, width, 0);
+
+    for (int t = 0; t < B->t_max; ++t) {
+        double *old  = t_bufs[t % 3];
+        double *cur  = t_bufs[(t + 1) % 3];
+        double *next = t_bufs[(t + 2) % 3];
+
+        B->kernel(next, cur, old, 1, B->i_max - 2, width, BATCH_WIDTH);
+        for (int c = 0; c < width; ++c) {
+            next[c] = 0.0;
+            next[last + c] = 0.0;
+        }
+    }
+
+    /* leave the final two generations where simulate() would */
+    batch_pack(B, t_bufs[B->t_max % 3], B->bufs[B->t_max % B->nbufs],
+               s0, width, 1);
+    batch_pack(B, t_bufs[(B->t_max + 1) % 3],
+               B->bufs[(B->t_max + 1) % B->nbufs], s0, width, 1);
+}
+
+/*
+ * Fallback when the tiles cannot be allocated: all steps on the calling
+ * thread, in the caller's arrays. The batch kernel runs across all strings
+ * at once where they sit side by side (WAVE_BATCH_INTERLEAVED) and on one
+ * string at a time otherwise; the bits are those of the tiled run.
+ */
+static double *batch_serial(const batch_t *B)
+{
+    const long ps = (long)B->point_stride;
+    const size_t last = (size_t)(B->i_max - 1) * B->point_stride;
+    const int side = (B->string_stride == 1);
+    const int width = side ? B->nstrings : 1;
+    const int n = side ? 1 : B->nstrings;
+
+    for (int t = 0; t < B->t_max; ++t) {
+        double *old  = B->bufs[t % B->nbufs];
+        double *cur  = B->bufs[(t + 1) % B->nbufs];
+        double *next = B->bufs[(t + 2) % B->nbufs];
+
+        for (int s = 0; s < n; ++s) {
+            const size_t off = (size_t)s * B->string_stride;
+            B->kernel(next + off, cur + off, old + off, 1, B->i_max - 2,
+                      width, ps);
+            for (int c = 0; c < width; ++c) {
+                next[off + c] = 0.0;
+                next[off + last + c] = 0.0;
             }
-            next_array[0] = 0.0;
-            next_array[i_max - 1] = 0.0;
-            double *tmp = old_array; old_array = current_array;
-            current_array = next_array; next_array = tmp;
         }
-        return current_array;
     }
+    return B->bufs[(B->t_max + 1) % B->nbufs];
+}
 
-    /* near-equal contiguous partition of [1 .. i_max-2] */
-    int base = (T > 0) ? (interior / T) : 0;
-    int rem  = (T > 0) ? (interior % T) : 0;
+static void *worker_batch(void *arg_void)
+{
+    batch_arg_t *A = (batch_arg_t *)arg_void;
+    batch_t *B = A->B;
+    int b;
 
-    for (int tid = 0; tid < T; ++tid) {
-        int extra = (tid < rem) ? 1 : 0;
-        int len   = base + extra;
+    affinity_pin(A->tid);
 
-        int offset = tid * base + (tid < rem ? tid : rem);
-        int start  = (len > 0) ? (1 + offset) : 1;
-        int end    = (len > 0) ? (start + len - 1) : 0;
+    while ((b = atomic_fetch_add(&B->next_block, 1)) < B->nblocks) {
+        int s0 = b * BATCH_WIDTH;
+        int width = B->nstrings - s0;
+        if (width > BATCH_WIDTH) width = BATCH_WIDTH;
+        batch_block(B, A->tile, s0, width);
+    }
+    return NULL;
+}
 
-        args[tid].S     = &S;
-        args[tid].tid   = tid;
-        args[tid].start = start;
-        args[tid].end   = end;
+double *simulate_batch(const int i_max, const int t_max, const int num_cpus,
+        const int nstrings, wave_batch_layout_t layout, double *old_arrays,
+        double *current_arrays, double *next_arrays)
+{
+    if (t_max <= 0 || nstrings <= 0 || i_max < 3) return current_arrays;
 
-        pthread_create(&threads[tid], NULL, worker, &args[tid]);
+    batch_t B;
+    B.i_max = i_max;
+    B.t_max = t_max;
+    B.nstrings = nstrings;
+    B.nblocks = (nstrings + BATCH_WIDTH - 1) / BATCH_WIDTH;
+    if (layout == WAVE_BATCH_INTERLEAVED) {
+        B.point_stride = nstrings;
+        B.string_stride = 1;
+    } else {
+        B.point_stride = 1;
+        B.string_stride = i_max;
+    }
+    B.bufs[0] = old_arrays;
+    B.bufs[1] = current_arrays;
+    B.bufs[2] = next_arrays;
+    B.nbufs = next_arrays ? 3 : 2;
+    B.kernel = wave_kernel_batch();
+    atomic_init(&B.next_block, 0);
+
+    int T = num_cpus;
+    if (T > B.nblocks) T = B.nblocks;
+    if (T < 1) T = 1;
+
+    const size_t tile = 3 * (size_t)i_max * BATCH_WIDTH;
+    batch_arg_t *args = (batch_arg_t *)malloc(sizeof(batch_arg_t) * T);
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * T);
+    void *tiles = NULL;
+    if (!args || !threads
+            || posix_memalign(&tiles, 64, sizeof(double) * tile * T) != 0) {
+        fprintf(stderr, "Batch allocation failed; running on one thread.\n");
+        free(args);
+        free(threads);
+        return batch_serial(&B);
     }
 
     for (int tid = 0; tid < T; ++tid) {
-        pthread_join(threads[tid], NULL);
+        args[tid].B = &B;
+        args[tid].tid = tid;
+        args[tid].tile = (double *)tiles + tid * tile;
     }
 
-    pthread_barrier_destroy(&S.barrier);
-    free(threads);
-    free(args);
+    if (pool_run(worker_batch, args, sizeof(batch_arg_t), T) != 0) {
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_create(&threads[tid], NULL, worker_batch, &args[tid]);
+        }
+        for (int tid = 0; tid < T; ++tid) {
+            pthread_join(threads[tid], NULL);
+        }
+    }
 
-    return S.cur;
+    free(tiles);
+    free(args);
+    free(threads);
+    return B.bufs[(t_max + 1) % B.nbufs];
 }
+
+const wave_backend_t wave_backend_pthreads = {
+    "pthreads", "pthreads solver (WAVE_SYNC, WAVE_SCHED modes)",
+    simulate, simulate_first_touch, 1,
+    wave_ctx_create, wave_step, wave_view, wave_destroy
+};
@@ -4,5 +4,35 @@
 
 #pragma once
 
+#include "wave_ctx.h"
+
+/* With next_array == NULL every step overwrites old_array in place, so only
+   two arrays are needed; the result is the same. */
 double *simulate(const int i_max, const int t_max, const int num_cpus,
         double *old_array, double *current_array, double *next_array);
+
+/* Zeroes the arrays from the threads that will compute on them (NUMA first
+   touch) and reports where every partition ended up. next_array may be
+   NULL. */
+void simulate_first_touch(const int i_max, const int num_cpus,
+        double *old_array, double *current_array, double *next_array);
+
+/* Layouts of the strings handed to simulate_batch(). */
+typedef enum {
+    WAVE_BATCH_SOA,          /* string s at arrays + s * i_max */
+    WAVE_BATCH_INTERLEAVED   /* point i of string s at arrays[i * nstrings + s] */
+} wave_batch_layout_t;
+
+/*
+ * Simulates nstrings independent strings of i_max points for t_max steps
+ * each; every array holds nstrings * i_max doubles in the given layout and
+ * next_arrays may again be NULL. The threads take blocks of strings and run
+ * them start to finish, so there is no synchronization between steps, and
+ * the stencil is vectorized across the strings of a block in either layout.
+ * Returns the array holding the final generation of all strings. When the
+ * per-thread tiles cannot be allocated it runs the strings in place on the
+ * calling thread instead, with the same result.
+ */
+double *simulate_batch(const int i_max, const int t_max, const int num_cpus,
+        const int nstrings, wave_batch_layout_t layout, double *old_arrays,
+        double *current_arrays, double *next_arrays);
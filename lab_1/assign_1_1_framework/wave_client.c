@@ -0,0 +1,192 @@
+/*
+ * wave_client.c
+ *
+ * Client of the assign1_1 server (server.h) and latency benchmark. Sends
+ * `jobs' requests, `inflight' at a time over one fresh connection each, and
+ * reports the end-to-end latency per round: connect, send, simulate and
+ * receive the result in binary. The last result is written to result.txt,
+ * so it can be compared with the one assign1_1 writes, and with
+ * WAVE_RESULT_RAW=path also as raw doubles, as the driver does.
+ *
+ * Usage: wave_client socket i_max t_max [initial_data] [jobs] [inflight]
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "file.h"
+#include "wave_proto.h"
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int read_all(int fd, void *buf, size_t len)
+{
+    char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+    const char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_un addr;
+    wave_request_t req;
+    wave_reply_t reply;
+    int init = WAVE_INIT_SIN, jobs = 100, inflight = 1;
+    int rounds, batch = 0;
+    wave_request_t *reqs;
+    double *lat, *result, sum = 0.0, server = 0.0;
+
+    if (argc < 4) {
+        printf("Usage: %s socket i_max t_max [initial_data] [jobs] "
+               "[inflight]\n", argv[0]);
+        printf(" - initial_data: sin, sinfull or gauss\n");
+        printf(" - jobs: requests to send (default 100)\n");
+        printf(" - inflight: requests per connection, sent before the "
+               "replies are read (default 1)\n");
+        return EXIT_FAILURE;
+    }
+
+    req.magic = WAVE_PROTO_MAGIC;
+    req.i_max = atoi(argv[2]);
+    req.t_max = atoi(argv[3]);
+    if (argc > 4) {
+        if (strcmp(argv[4], "sinfull") == 0) init = WAVE_INIT_SINFULL;
+        else if (strcmp(argv[4], "gauss") == 0) init = WAVE_INIT_GAUSS;
+        else if (strcmp(argv[4], "sin") != 0) {
+            printf("Unknown initial mode: %s.\n", argv[4]);
+            return EXIT_FAILURE;
+        }
+    }
+    req.init = init;
+    if (argc > 5) jobs = atoi(argv[5]);
+    if (argc > 6) inflight = atoi(argv[6]);
+    if (req.i_max < 3 || req.t_max < 1 || jobs < 1 || inflight < 1) {
+        printf("argument error\n");
+        return EXIT_FAILURE;
+    }
+    if (strlen(argv[1]) >= sizeof(addr.sun_path)) {
+        printf("argument error: socket path too long.\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, argv[1]);
+
+    rounds = (jobs + inflight - 1) / inflight;
+    lat = malloc(sizeof(double) * rounds);
+    result = malloc(sizeof(double) * (size_t)req.i_max);
+    reqs = malloc(sizeof(req) * inflight);
+    if (!lat || !result || !reqs) {
+        fprintf(stderr, "Could not allocate enough memory, aborting.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int k = 0; k < inflight; ++k)
+        reqs[k] = req;
+
+    for (int r = 0; r < rounds; ++r) {
+        int n = (jobs - r * inflight < inflight) ? jobs - r * inflight
+                                                 : inflight;
+        double t0 = now();
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0 || connect(fd, (struct sockaddr *)&addr,
+                              sizeof(addr)) != 0) {
+            fprintf(stderr, "Cannot connect to %s: %s\n", argv[1],
+                    strerror(errno));
+            return EXIT_FAILURE;
+        }
+        /* one write, so the server sees the whole round at once */
+        if (write_all(fd, reqs, sizeof(req) * n) != 0) {
+            fprintf(stderr, "Sending the requests failed.\n");
+            return EXIT_FAILURE;
+        }
+        for (int k = 0; k < n; ++k) {
+            if (read_all(fd, &reply, sizeof(reply)) != 0
+                    || (reply.status == WAVE_REPLY_OK
+                        && read_all(fd, result,
+                                    sizeof(double) * reply.i_max) != 0)) {
+                fprintf(stderr, "The server hung up.\n");
+                return EXIT_FAILURE;
+            }
+            if (reply.status != WAVE_REPLY_OK) {
+                fprintf(stderr, "The server refused the job (status %d).\n",
+                        reply.status);
+                return EXIT_FAILURE;
+            }
+            server += reply.seconds / reply.batch;
+            if (reply.batch > batch)
+                batch = reply.batch;
+        }
+        close(fd);
+        lat[r] = now() - t0;
+        sum += lat[r];
+    }
+
+    qsort(lat, rounds, sizeof(double), cmp_double);
+    printf("Jobs: %d, %d per connection, batches of up to %d\n", jobs,
+           inflight, batch);
+    printf("Latency: min %g ms, median %g ms, mean %g ms per round\n",
+           1e3 * lat[0], 1e3 * lat[rounds / 2], 1e3 * sum / rounds);
+    printf("Solver: %g ms per job\n", 1e3 * server / jobs);
+    printf("Throughput: %g jobs/s\n", jobs / sum);
+
+    file_write_double_array("result.txt", result, req.i_max);
+    if (getenv("WAVE_RESULT_RAW")) {
+        const char *raw = getenv("WAVE_RESULT_RAW");
+        FILE *fp = fopen(raw, "wb");
+
+        if (!fp || fwrite(result, sizeof(double), req.i_max, fp)
+                   != (size_t)req.i_max)
+            fprintf(stderr, "Could not write %s.\n", raw);
+        if (fp)
+            fclose(fp);
+    }
+    free(lat);
+    free(result);
+    free(reqs);
+    return EXIT_SUCCESS;
+}
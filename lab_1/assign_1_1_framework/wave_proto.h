@@ -0,0 +1,45 @@
+/*
+ * wave_proto.h
+ *
+ * Wire format of the assign1_1 server (server.h). A client connects to the
+ * Unix socket and writes any number of requests; for every request, in
+ * order, the server writes a reply header followed, when status is
+ * WAVE_REPLY_OK, by the i_max doubles of generation t_max. Everything is in
+ * the host's byte order and layout, since both ends run on the same
+ * machine.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define WAVE_PROTO_MAGIC 0x57415631u   /* "WAV1" */
+
+/* Initial data of a request, the built-in modes of ../common/initial.h. */
+enum {
+    WAVE_INIT_SIN,
+    WAVE_INIT_SINFULL,
+    WAVE_INIT_GAUSS
+};
+
+enum {
+    WAVE_REPLY_OK = 0,
+    WAVE_REPLY_BAD_REQUEST = -1,   /* bad magic, size, steps or init */
+    WAVE_REPLY_NO_MEMORY = -2
+};
+
+typedef struct {
+    uint32_t magic;
+    int32_t i_max;
+    int32_t t_max;
+    int32_t init;
+} wave_request_t;
+
+typedef struct {
+    int32_t status;
+    int32_t i_max;      /* doubles that follow, 0 on error */
+    int32_t batch;      /* jobs simulated together with this one, itself
+                           included */
+    int32_t reserved;
+    double seconds;     /* solver time of the job (of its whole batch) */
+} wave_reply_t;
@@ -6,67 +6,644 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <omp.h>
 
+#include "affinity.h"
+#include "backend.h"
+#include "coeff.h"
+#include "precision.h"
+#include "reduce.h"
 #include "simulate.h"
+#include "trapezoid.h"
+#include "wave_kernels.h"
+#include "window.h"
 
-#define C_CONST 0.15  /* spatial impact constant c */
+/* Points per work item handed to the stencil kernel. OMP_SCHEDULE chunk sizes
+   count these blocks, not single points. */
+#define BLOCK 64
 
 /*
- * Executes the entire simulation.
- *
- * Implement your code here.
- *
- * i_max: how many data points are on a single wave
- * t_max: how many iterations the simulation should run
- * num_threads: how many threads to use
- * old_array: array of size i_max filled with data for t-1
- * current_array: array of size i_max filled with data for t
- * next_array: array of size i_max. You should fill this with t+1
+ * First-touch initialization: zeroes the three arrays with the same
+ * parallel loop (and therefore, under a static OMP_SCHEDULE, the same
+ * block-to-thread mapping) the solver uses, so pages land on the node of the
+ * thread that computes them. Reports the CPU, the number of blocks touched
+ * and the node of the first of them for every thread.
  */
-double *simulate(const int i_max, const int t_max, const int num_threads,
+void simulate_first_touch(const int i_max, const int num_threads,
         double *old_array, double *current_array, double *next_array)
 {
-    if (t_max <= 0) return current_array;
+    const int nblocks = (i_max - 2 + BLOCK - 1) / BLOCK;
+    int nthreads = 1;
+    int *info = calloc(4 * (size_t)num_threads, sizeof(int));
+
+    omp_set_num_threads(num_threads);
+
+    #pragma omp parallel default(none) shared(i_max, nblocks, old_array, \
+            current_array, next_array, info, nthreads)
+    {
+        int tid = omp_get_thread_num();
+        int cpu = affinity_pin(tid);
+        int first = -1, touched = 0;
+
+        #pragma omp for schedule(runtime)
+        for (int b = 0; b < nblocks; ++b) {
+            int i_begin = 1 + b * BLOCK;
+            int i_end = i_begin + BLOCK - 1;
+            if (i_end > i_max - 2) i_end = i_max - 2;
+            size_t bytes = sizeof(double) * (i_end - i_begin + 1);
+
+            memset(old_array + i_begin, 0, bytes);
+            memset(current_array + i_begin, 0, bytes);
+            if (next_array) memset(next_array + i_begin, 0, bytes);
+            if (first < 0) first = i_begin;
+            ++touched;
+        }
+
+        #pragma omp single nowait
+        {
+            old_array[0] = current_array[0] = 0.0;
+            old_array[i_max - 1] = current_array[i_max - 1] = 0.0;
+            if (next_array) next_array[0] = next_array[i_max - 1] = 0.0;
+        }
+
+        if (info) {
+            info[4 * tid]     = cpu;
+            info[4 * tid + 1] = touched;
+            info[4 * tid + 2] = first;
+            info[4 * tid + 3] = (first >= 0)
+                ? affinity_node_of(current_array + first) : -1;
+        }
+        if (tid == 0) nthreads = omp_get_num_threads();
+    }
+
+    for (int tid = 0; info && tid < nthreads; ++tid) {
+        fprintf(stderr, "Thread %d: cpu %d, %d blocks from %d, node %d\n",
+                tid, info[4 * tid], info[4 * tid + 1], info[4 * tid + 2],
+                info[4 * tid + 3]);
+    }
+    free(info);
+}
+
+/*
+ * Float-storage variant for WAVE_PRECISION=float|mixed. The caller's arrays
+ * are converted in and out of f (3 * i_max floats) with the same block loop
+ * as the time steps.
+ * Buffers are picked by t % 3 instead of rotated, so the implicit barrier of
+ * the block loop is the only one per step; the blocks holding the fixed ends
+ * zero them as part of the step. bufs[2] is NULL (nbufs == 2) when the
+ * caller runs without a next array.
+ */
+static double *simulate_float(const int i_max, const int t_max,
+        const int num_threads, wave_precision_t prec, double *bufs[3],
+        int nbufs, float *f)
+{
+    float *fbufs[3] = { f, f + i_max, f + 2 * (size_t)i_max };
+    double *res_old = bufs[t_max % nbufs];
+    double *res_cur = bufs[(t_max + 1) % nbufs];
+
+    wave_kernel_f_t kernel = wave_kernel_f_select(prec);
+    const int nblocks = (i_max - 2 + BLOCK - 1) / BLOCK;
+
+    omp_set_num_threads(num_threads);
+
+    #pragma omp parallel default(none) shared(i_max, t_max, bufs, fbufs, \
+            res_old, res_cur, kernel, nblocks)
+    {
+        affinity_pin(omp_get_thread_num());
+
+        #pragma omp for schedule(runtime)
+        for (int b = 0; b < nblocks + 2; ++b) {
+            int i_begin = (b < nblocks) ? 1 + b * BLOCK
+                        : (b == nblocks) ? 0 : i_max - 1;
+            int i_end = (b < nblocks) ? i_begin + BLOCK - 1 : i_begin;
+            if (b < nblocks && i_end > i_max - 2) i_end = i_max - 2;
+            for (int i = i_begin; i <= i_end; ++i) {
+                fbufs[0][i] = (float)bufs[0][i];
+                fbufs[1][i] = (float)bufs[1][i];
+            }
+        }
+
+        for (int t = 0; t < t_max; ++t) {
+            float *old  = fbufs[t % 3];
+            float *cur  = fbufs[(t + 1) % 3];
+            float *next = fbufs[(t + 2) % 3];
+
+            #pragma omp for schedule(runtime)
+            for (int b = 0; b < nblocks; ++b) {
+                int i_begin = 1 + b * BLOCK;
+                int i_end = i_begin + BLOCK - 1;
+                if (i_end > i_max - 2) i_end = i_max - 2;
+                kernel(next, cur, old, i_begin, i_end);
+                if (b == 0) next[0] = 0.0f;
+                if (b == nblocks - 1) next[i_max - 1] = 0.0f;
+            }
+        }
+
+        const float *f_old = fbufs[t_max % 3];
+        const float *f_cur = fbufs[(t_max + 1) % 3];
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < i_max; ++i) {
+            res_old[i] = f_old[i];
+            res_cur[i] = f_cur[i];
+        }
+    }
+
+    return res_cur;
+}
+
+/* Trapezoids narrower than this run as one serial task; simulate_trap()
+   lowers it so that every thread gets some, down to TRAP_BASE. */
+#define TRAP_TASK 8192
+
+/*
+ * Parallel trapezoid walk. A wide trapezoid is cut into two upright pieces
+ * that shrink towards the middle, and therefore do not depend on each other,
+ * and the inverted triangle growing between them once both are done. The two
+ * pieces become tasks; ones narrower than 2 * task fall back to the serial
+ * walk.
+ */
+static void trap_tasks(const wave_trap_t *w, int task, int t0, int t1,
+        int x0, int dx0, int x1, int dx1)
+{
+    const int dt = t1 - t0;
+    const int xm = x0 + (x1 - x0) / 2;
+    const int top = (x1 + dx1 * dt) - (x0 + dx0 * dt);
+    const int wide = (top > x1 - x0) ? top : x1 - x0;
+
+    if (dt <= 0) return;
+    if (x1 - x0 >= 2 * task && xm - dt >= x0 + dx0 * dt
+            && xm + dt <= x1 + dx1 * dt) {
+        #pragma omp task
+        trap_tasks(w, task, t0, t1, x0, dx0, xm, -1);
+        #pragma omp task
+        trap_tasks(w, task, t0, t1, xm, 1, x1, dx1);
+        #pragma omp taskwait
+        trap_tasks(w, task, t0, t1, xm, -1, xm, 1);
+    } else if (dt > 1 && wide >= 2 * task) {
+        int h = dt / 2;
+        trap_tasks(w, task, t0, t0 + h, x0, dx0, x1, dx1);
+        trap_tasks(w, task, t0 + h, t1, x0 + dx0 * h, dx0, x1 + dx1 * h,
+                   dx1);
+    } else {
+        wave_trapezoid(w, t0, t1, x0, dx0, x1, dx1);
+    }
+}
+
+/*
+ * Cache-oblivious variant for WAVE_SCHED=trap: the whole space-time domain
+ * is one trapezoid walked by trap_tasks() from a single thread, with the
+ * other threads of the team executing the tasks it spawns.
+ */
+static double *simulate_trap(const int i_max, const int t_max,
+        const int num_threads, double *bufs[3], int nbufs)
+{
+    wave_trap_t w = {
+        { bufs[0], bufs[1], bufs[2] }, nbufs, i_max, wave_kernel_select()
+    };
+    /* about two tasks per thread across the wave, so that waves narrower
+       than 2 * TRAP_TASK are still split */
+    int task = (i_max - 2) / (2 * num_threads);
+
+    if (task > TRAP_TASK) task = TRAP_TASK;
+    if (task < TRAP_BASE) task = TRAP_BASE;
+
+    omp_set_num_threads(num_threads);
+
+    #pragma omp parallel default(none) shared(w, task, i_max, t_max)
+    {
+        affinity_pin(omp_get_thread_num());
+
+        #pragma omp single
+        trap_tasks(&w, task, 0, t_max, 1, 0, i_max - 1, 0);
+    }
+
+    return bufs[(t_max + 1) % nbufs];
+}
+
+/* Solver state kept between wave_step() calls. */
+struct wave_ctx {
+    int i_max;
+    int num_threads;
+    double *bufs[3];       /* generation t-1, t and the spare buffer */
+    int nbufs;
+    wave_precision_t prec;
+    float *fbuf;           /* float storage for reduced precision */
+    int trap;              /* WAVE_SCHED=trap */
+    int lines;             /* WAVE_SCHED=static */
+    wave_kernel_t kernel;
+    const double *coef;    /* WAVE_COEFF, NULL when c is uniform */
+    wave_kernel_coef_t ckernel;
+    wave_kernel4_t kernel4;   /* WAVE_ORDER=4, NULL for second order */
+    int reach;             /* points per side a step spreads the wave */
+    int lo, hi;            /* active window of the next step */
+    wave_series_t series;
+    wave_kernel_reduce_t rkernel;
+    long steps;
+};
+
+wave_ctx_t *wave_ctx_create(int i_max, int num_threads, double *old_array,
+        double *current_array, double *next_array)
+{
+    wave_ctx_t *ctx = calloc(1, sizeof(wave_ctx_t));
+    if (!ctx) return NULL;
+
+    ctx->i_max = i_max;
+    ctx->num_threads = num_threads;
+    ctx->bufs[0] = old_array;
+    ctx->bufs[1] = current_array;
+    ctx->bufs[2] = next_array;
+    ctx->nbufs = next_array ? 3 : 2;
+
+    /* a varying c and the fourth-order stencil run on the double block
+       loop only */
+    ctx->coef = wave_coeff(i_max);
+    if (wave_order() == 4 && ctx->coef)
+        fprintf(stderr, "Fourth order needs a uniform c; using second "
+                "order.\n");
+    else if (wave_order() == 4)
+        ctx->kernel4 = wave_kernel4();
+    ctx->reach = ctx->kernel4 ? 2 : 1;
+    const int plain = !ctx->coef && !ctx->kernel4;
+
+    ctx->prec = wave_precision();
+    if (!plain && ctx->prec != WAVE_DOUBLE) {
+        fprintf(stderr, "Reduced precision needs a uniform c and the "
+                "second-order stencil; using double.\n");
+        ctx->prec = WAVE_DOUBLE;
+    }
+    /* the float arrays come on top of the caller's doubles: half as many
+       bytes streamed per step, half as many more held */
+    if (ctx->prec != WAVE_DOUBLE && i_max >= 3) {
+        ctx->fbuf = malloc(sizeof(float) * 3 * (size_t)i_max);
+        if (!ctx->fbuf) {
+            fprintf(stderr, "Float buffer allocation failed; using double.\n");
+            ctx->prec = WAVE_DOUBLE;
+        }
+    }
 
-    /* Work with local pointers we’ll rotate; caller owns the storage. */
-    double *old  = old_array;
-    double *cur  = current_array;
-    double *next = next_array;
+    const char *sched = getenv("WAVE_SCHED");
+    ctx->trap = !ctx->fbuf && plain && sched
+                && strcmp(sched, "trap") == 0 && i_max >= 3;
+    ctx->lines = !ctx->fbuf && !ctx->trap && sched
+                 && strcmp(sched, "static") == 0;
+
+    /* Only the active window [lo, hi] can be nonzero (see window.h); it
+       widens every step and the block loop is re-split over it each time.
+       next[] must hold zeros where the window has not reached yet. */
+    ctx->lo = 1;
+    ctx->hi = i_max - 2;
+    if (!ctx->fbuf && !ctx->trap) {
+        /* Pick the SIMD kernel once, before any thread can ask for it;
+           arrays larger than the last-level cache get the streaming-store
+           variant, which the in-place update does not need. */
+        ctx->kernel = !next_array ? wave_kernel_select()
+            : wave_kernel_for(3 * sizeof(double) * (size_t)i_max);
+        if (ctx->coef)
+            ctx->ckernel = wave_kernel_coef();
+
+        wave_window(old_array, current_array, i_max, &ctx->lo, &ctx->hi);
+        wave_window_grow_by(i_max, &ctx->lo, &ctx->hi, ctx->reach);
+        if (next_array && (ctx->lo > 1 || ctx->hi < i_max - 2))
+            wave_window_clear(next_array, i_max, ctx->lo, ctx->hi);
+    }
+
+    /* In-situ reductions (reduce.h): on the steps that get a row the block
+       loop runs the reducing kernel, and the reduction clause combines the
+       per-thread sums at the loop's own barrier. */
+    if (!ctx->fbuf && !ctx->trap && plain
+            && wave_series_init(&ctx->series))
+        ctx->rkernel = wave_kernel_reduce();
+
+    return ctx;
+}
+
+/* n steps of the block-loop solver, starting from the context's buffers. */
+static void step_blocks(wave_ctx_t *ctx, const int t_max)
+{
+    const int i_max = ctx->i_max;
+    const int num_threads = ctx->num_threads;
+    const int t0 = (int)ctx->steps;
+
+    /* Work with local pointers we’ll rotate; the caller owns the storage.
+       Without a next array every step writes over old in place. */
+    const int in_place = (ctx->nbufs == 2);
+    double *old  = ctx->bufs[0];
+    double *cur  = ctx->bufs[1];
+    double *next = in_place ? old : ctx->bufs[2];
+    wave_kernel_t kernel = ctx->kernel;
+    wave_kernel_coef_t ckernel = ctx->ckernel;
+    const double *coef = ctx->coef;
+    wave_kernel4_t kernel4 = ctx->kernel4;
+    const int reach = ctx->reach;
+    wave_kernel_reduce_t rkernel = ctx->rkernel;
+    wave_series_t *series = &ctx->series;
+    int lo = ctx->lo, hi = ctx->hi;
+    double kin = 0.0, grad = 0.0, l2 = 0.0, amax = 0.0;
 
     /* Set the requested thread count (can be overridden by OMP_NUM_THREADS). */
     omp_set_num_threads(num_threads);
 
     /* One parallel region around the whole time loop to avoid per-step spawn cost. */
-    #pragma omp parallel default(none) shared(i_max, t_max, old, cur, next)
+    #pragma omp parallel default(none) \
+            shared(i_max, t_max, t0, old, cur, next, kernel, in_place, lo, hi, \
+                   series, rkernel, kin, grad, l2, amax, ckernel, coef, \
+                   kernel4, reach)
     {
+        affinity_pin(omp_get_thread_num());
+
         for (int t = 0; t < t_max; ++t) {
 
-            /* Phase 1: all threads compute their chunk of interior points into next[]. 
+            /* Phase 1: all threads compute their chunk of the window into next[].
                schedule(runtime) lets you switch policy/chunk via OMP_SCHEDULE at run time. */
-            #pragma omp for schedule(runtime)
-            for (int i = 1; i < i_max - 1; ++i) {
-                next[i] = 2.0 * cur[i] - old[i]
-                        + C_CONST * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
+            const int nblocks = (hi - lo + 1 + BLOCK - 1) / BLOCK;
+
+            if (wave_series_due(series, t0 + t)) {
+                /* every block sums the gradient pairs (i, i+1) of its
+                   points; the first also takes the pair (lo-1, lo) */
+                #pragma omp for schedule(runtime) \
+                        reduction(+:kin, grad, l2) reduction(max:amax)
+                for (int b = 0; b < nblocks; ++b) {
+                    int i_begin = lo + b * BLOCK;
+                    int i_end = i_begin + BLOCK - 1;
+                    wave_sums_t acc = { 0.0, 0.0, 0.0, 0.0 };
+                    if (i_end > hi) i_end = hi;
+                    rkernel(next, cur, old, i_begin, i_end, &acc);
+                    if (b == 0) {
+                        double g = cur[lo] - cur[lo - 1];
+                        acc.grad += g * g;
+                    }
+                    kin += acc.kin;
+                    grad += acc.grad;
+                    l2 += acc.l2;
+                    if (acc.amax > amax) amax = acc.amax;
+                }
+            } else {
+                #pragma omp for schedule(runtime)
+                for (int b = 0; b < nblocks; ++b) {
+                    int i_begin = lo + b * BLOCK;
+                    int i_end = i_begin + BLOCK - 1;
+                    if (i_end > hi) i_end = hi;
+                    if (coef)
+                        ckernel(next, cur, old, coef, i_begin, i_end);
+                    else if (kernel4)
+                        kernel4(next, cur, old, i_max, i_begin, i_end);
+                    else
+                        kernel(next, cur, old, i_begin, i_end);
+                }
             }
             /* implicit barrier here at end of omp for (since no nowait) */
 
-            /* Single-thread section: set fixed boundaries and rotate buffers. */
+            /* Single-thread section: set fixed boundaries, record the
+               reductions, rotate buffers and widen the window. */
             #pragma omp single
             {
                 next[0] = 0.0;
                 next[i_max - 1] = 0.0;
 
+                if (wave_series_due(series, t0 + t)) {
+                    wave_sums_t sum = { kin, grad, l2, amax };
+                    wave_series_add(series, t0 + t, &sum);
+                    kin = grad = l2 = amax = 0.0;
+                }
+
                 double *tmp = old;
                 old = cur;
                 cur = next;
-                next = tmp;
+                next = in_place ? old : tmp;
+
+                wave_window_grow_by(i_max, &lo, &hi, reach);
             }
             /* implicit barrier at end of single (since no nowait):
-               guarantees all threads see rotated pointers before next iteration */
+               guarantees all threads see rotated pointers and the new window
+               before next iteration */
+        }
+    }
+
+    ctx->lo = lo;
+    ctx->hi = hi;
+}
+
+/* Doubles per cache line; the driver's arrays start on a line. */
+#define LINE 8
+
+/* Per-thread partial reductions, one cache line each. */
+typedef struct {
+    wave_sums_t sums;
+    char pad[64 - sizeof(wave_sums_t)];
+} sums_slot_t;
+
+/*
+ * Static share of thread tid in the window [lo, hi]: whole cache lines of
+ * next[], so no two threads write the same line. Empty when begin > end.
+ */
+static void line_range(int lo, int hi, int tid, int nthreads, int *begin,
+        int *end)
+{
+    const int first = lo / LINE;
+    const long nlines = (lo <= hi) ? hi / LINE - first + 1 : 0;
+    const int b = first + (int)(nlines * tid / nthreads);
+    const int e = first + (int)(nlines * (tid + 1) / nthreads);
+
+    *begin = (b * LINE > lo) ? b * LINE : lo;
+    *end = (e * LINE - 1 < hi) ? e * LINE - 1 : hi;
+}
+
+/*
+ * WAVE_SCHED=static: the block loop with one barrier per step. Buffers are
+ * picked by t % nbufs instead of rotated, every thread widens its own copy
+ * of the window and computes a fixed range of whole cache lines of it, and
+ * the threads owning the ends zero them, so nothing is left for a single
+ * thread between steps. Reductions go to per-thread slots, alternating by
+ * step parity, and thread 0 adds up a step's after its barrier: a slot is
+ * written again only two steps later, once thread 0 has passed the next
+ * barrier. OMP_SCHEDULE is ignored.
+ */
+static void step_static(wave_ctx_t *ctx, const int t_max)
+{
+    const int i_max = ctx->i_max;
+    const int t0 = (int)ctx->steps;
+    const int nbufs = ctx->nbufs;
+    double *bufs[3] = { ctx->bufs[0], ctx->bufs[1], ctx->bufs[2] };
+    wave_kernel_t kernel = ctx->kernel;
+    wave_kernel_coef_t ckernel = ctx->ckernel;
+    const double *coef = ctx->coef;
+    wave_kernel4_t kernel4 = ctx->kernel4;
+    const int reach = ctx->reach;
+    wave_kernel_reduce_t rkernel = ctx->rkernel;
+    wave_series_t *series = &ctx->series;
+    const int lo0 = ctx->lo, hi0 = ctx->hi;
+    sums_slot_t *slots = NULL;
+
+    if (rkernel) {
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64,
+                sizeof(sums_slot_t) * 2 * ctx->num_threads) != 0) {
+            fprintf(stderr, "Reduction slot allocation failed; "
+                    "reductions off.\n");
+            series->every = 0;
+        } else {
+            slots = (sums_slot_t *)mem;
         }
     }
 
+    omp_set_num_threads(ctx->num_threads);
+
+    #pragma omp parallel default(none) \
+            shared(i_max, t_max, t0, nbufs, bufs, kernel, ckernel, coef, \
+                   kernel4, reach, rkernel, series, lo0, hi0, slots, ctx)
+    {
+        const int tid = omp_get_thread_num();
+        const int nthreads = omp_get_num_threads();
+        int lo = lo0, hi = hi0;
+
+        affinity_pin(tid);
+
+        for (int t = 0; t < t_max; ++t) {
+            double *old  = bufs[t % nbufs];
+            double *cur  = bufs[(t + 1) % nbufs];
+            double *next = bufs[(t + 2) % nbufs];
+            const int due = wave_series_due(series, t0 + t);
+            int i_begin, i_end;
+
+            line_range(lo, hi, tid, nthreads, &i_begin, &i_end);
+            if (due) {
+                wave_sums_t acc = { 0.0, 0.0, 0.0, 0.0 };
+                if (i_begin <= i_end) {
+                    rkernel(next, cur, old, i_begin, i_end, &acc);
+                    if (i_begin == lo) {
+                        double g = cur[lo] - cur[lo - 1];
+                        acc.grad += g * g;
+                    }
+                }
+                slots[(t % 2) * nthreads + tid].sums = acc;
+            } else if (i_begin <= i_end) {
+                if (coef)
+                    ckernel(next, cur, old, coef, i_begin, i_end);
+                else if (kernel4)
+                    kernel4(next, cur, old, i_max, i_begin, i_end);
+                else
+                    kernel(next, cur, old, i_begin, i_end);
+            }
+            if (tid == 0) next[0] = 0.0;
+            if (tid == nthreads - 1) next[i_max - 1] = 0.0;
+            wave_window_grow_by(i_max, &lo, &hi, reach);
+
+            #pragma omp barrier
+
+            if (due && tid == 0) {
+                wave_sums_t sum = slots[(t % 2) * nthreads].sums;
+                for (int k = 1; k < nthreads; ++k)
+                    wave_sums_merge(&sum, &slots[(t % 2) * nthreads + k].sums);
+                wave_series_add(series, t0 + t, &sum);
+            }
+        }
+
+        if (tid == 0) {
+            ctx->lo = lo;
+            ctx->hi = hi;
+        }
+    }
+
+    free(slots);
+}
+
+int wave_step(wave_ctx_t *ctx, int n)
+{
+    if (!ctx) return -1;
+    if (n <= 0) return 0;
+
+    if (ctx->fbuf)
+        simulate_float(ctx->i_max, n, ctx->num_threads, ctx->prec, ctx->bufs,
+                       ctx->nbufs, ctx->fbuf);
+    else if (ctx->trap)
+        simulate_trap(ctx->i_max, n, ctx->num_threads, ctx->bufs, ctx->nbufs);
+    else if (ctx->lines)
+        step_static(ctx, n);
+    else
+        step_blocks(ctx, n);
+
+    /* after n steps generation t-1 is in bufs[n % nbufs] */
+    double *bufs[3] = { ctx->bufs[0], ctx->bufs[1], ctx->bufs[2] };
+    for (int j = 0; j < ctx->nbufs; ++j)
+        ctx->bufs[j] = bufs[(n + j) % ctx->nbufs];
+    ctx->steps += n;
+    return 0;
+}
+
+const double *wave_view(const wave_ctx_t *ctx, const double **prev)
+{
+    if (prev) *prev = ctx->bufs[0];
+    return ctx->bufs[1];
+}
+
+void wave_destroy(wave_ctx_t *ctx)
+{
+    if (!ctx) return;
+    wave_series_finish(&ctx->series);
+    free(ctx->fbuf);
+    free(ctx);
+}
+
+/*
+ * Executes the entire simulation.
+ *
+ * Implement your code here.
+ *
+ * i_max: how many data points are on a single wave
+ * t_max: how many iterations the simulation should run
+ * num_threads: how many threads to use
+ * old_array: array of size i_max filled with data for t-1
+ * current_array: array of size i_max filled with data for t
+ * next_array: array of size i_max. You should fill this with t+1, or NULL
+ *             to overwrite old_array in place and get by with two arrays
+ */
+double *simulate(const int i_max, const int t_max, const int num_threads,
+        double *old_array, double *current_array, double *next_array)
+{
+    if (t_max <= 0) return current_array;
+
+    wave_ctx_t *ctx = wave_ctx_create(i_max, num_threads, old_array,
+                                      current_array, next_array);
+    if (!ctx) {
+        fprintf(stderr, "Context allocation failed; falling back to "
+                "sequential.\n");
+        double *bufs[3] = { old_array, current_array, next_array };
+        const int nbufs = next_array ? 3 : 2;
+        /* the same stencil as the team would have run, in double */
+        const double *coef = wave_coeff(i_max);
+        wave_kernel_t kernel = wave_kernel_select();
+        wave_kernel_coef_t ckernel = coef ? wave_kernel_coef() : NULL;
+        wave_kernel4_t kernel4 = (!coef && wave_order() == 4)
+                               ? wave_kernel4() : NULL;
+
+        for (int t = 0; t < t_max; ++t) {
+            double *old  = bufs[t % nbufs];
+            double *cur  = bufs[(t + 1) % nbufs];
+            double *next = bufs[(t + 2) % nbufs];
+            if (ckernel)
+                ckernel(next, cur, old, coef, 1, i_max - 2);
+            else if (kernel4)
+                kernel4(next, cur, old, i_max, 1, i_max - 2);
+            else
+                kernel(next, cur, old, 1, i_max - 2);
+            next[0] = 0.0;
+            next[i_max - 1] = 0.0;
+        }
+        return bufs[(t_max + 1) % nbufs];
+    }
+
+    wave_step(ctx, t_max);
+
     /* After t_max rotations, cur points to the final generation. */
-    return cur;
-}
\ No newline at end of file
+    double *res = ctx->bufs[1];
+    wave_destroy(ctx);
+    return res;
+}
+
+const wave_backend_t wave_backend_omp = {
+    "omp", "OpenMP solver (OMP_SCHEDULE, WAVE_SCHED=trap|static)",
+    simulate, simulate_first_touch, 1,
+    wave_ctx_create, wave_step, wave_view, wave_destroy
+};
@@ -4,5 +4,15 @@
 
 #pragma once
 
+#include "wave_ctx.h"
+
+/* With next_array == NULL every step overwrites old_array in place, so only
+   two arrays are needed; the result is the same. */
 double *simulate(const int i_max, const int t_max, const int num_threads,
         double *old_array, double *current_array, double *next_array);
+
+/* Zeroes the arrays from the threads that will compute on them (NUMA first
+   touch) and reports where every thread's blocks ended up. next_array may
+   be NULL. */
+void simulate_first_touch(const int i_max, const int num_threads,
+        double *old_array, double *current_array, double *next_array);
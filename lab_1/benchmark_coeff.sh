@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Uniform c vs a coefficient array (WAVE_COEFF) for the lab_1 solvers.
+#
+# The constant kernel reads cur[] and old[] and writes next[]: 32 bytes per
+# point to/from memory with ordinary stores. The variable-coefficient kernel
+# also streams coef[], 40 bytes per point. Streaming stores are switched off
+# for both runs (the coefficient kernels have none), so the difference in
+# the CSV is the extra stream alone: next to nothing while the arrays fit in
+# cache, up to 40/32 = 1.25x the time once the sweep is memory bound.
+#
+# The coefficient file varies c smoothly between 0.05 and 0.15 so every
+# point really takes the variable path.
+
+# ---- CONFIG (edit here or override via env) ----
+BIN="${BIN:-./wave/wave}"
+BACKENDS=(${BACKENDS:-simd pthreads omp})
+INIT="${INIT:-sinfull}"
+THREADS="${THREADS:-8}"
+SIZES=(100000 1000000 10000000 50000000)
+POINTS="${POINTS:-2000000000}"      # i_max * t_max per run
+CSV="${CSV:-results_coeff.csv}"
+COEFDIR="${COEFDIR:-/tmp}"
+
+# -np 1 = single process; set RUN= to run directly on the current machine
+RUN="${RUN-prun -v -np 1}"
+
+extract_time() {
+  awk '/^Took /{t=$2} END{print t+0}'
+}
+
+if [[ ! -x "$BIN" ]]; then
+  echo "ERROR: binary not found or not executable: ${BIN} (make -C wave)" >&2
+  exit 1
+fi
+
+echo "backend,i_max,t_max,threads,c,bytes_per_point,ns_per_point,gb_per_sec" > "$CSV"
+
+for i_max in "${SIZES[@]}"; do
+  t_max=$(( POINTS / i_max ))
+  (( t_max < 1 )) && t_max=1
+  coef="${COEFDIR}/coeff_${i_max}.txt"
+  [[ -f "$coef" ]] || awk -v n="$i_max" \
+    'BEGIN { for (i = 0; i < n; i++) printf "%.6f\n", 0.1 + 0.05 * sin(i * 0.001) }' \
+    > "$coef"
+
+  for be in "${BACKENDS[@]}"; do
+    for c in uniform array; do
+      echo "== ${be} i_max=${i_max} t_max=${t_max} c=${c} =="
+      if [[ "$c" == array ]]; then file="$coef"; bytes=40; else file=""; bytes=32; fi
+      out="$(WAVE_NT=off WAVE_COEFF="$file" $RUN "$BIN" --backend="$be" \
+             "$i_max" "$t_max" "$THREADS" "$INIT" 2>&1 | tee /dev/stderr)"
+      time_sec="$(printf "%s\n" "$out" | extract_time || true)"
+      if [[ -z "${time_sec}" || "${time_sec}" == "0" ]]; then
+        echo "  WARNING: couldn't parse time; skipping." >&2
+        continue
+      fi
+      awk -v b="$be" -v n="$i_max" -v t="$t_max" -v thr="$THREADS" -v c="$c" \
+          -v by="$bytes" -v s="$time_sec" 'BEGIN {
+        ns = s * 1e9 / ((n - 2) * t)
+        printf "%s,%d,%d,%d,%s,%d,%.4f,%.2f\n", b, n, t, thr, c, by, ns, by / ns
+      }' >> "$CSV"
+    done
+  done
+done
+
+echo "Wrote ${CSV}"
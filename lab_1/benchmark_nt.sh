@@ -0,0 +1,71 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Regular vs non-temporal (streaming) stores for both lab_1 solvers.
+#
+# Every step reads cur[] and old[] and writes next[]. With ordinary stores
+# the write first pulls the line of next[] into the cache (read for
+# ownership), so a point moves 32 bytes to/from memory; streaming stores
+# skip that read and move 24. The CSV lists those model bytes per point next
+# to the measured time per point and the bandwidth they imply, so the two
+# modes can be compared below and above the last-level cache size.
+
+# ---- CONFIG (edit here or override via env) ----
+BINS=(
+  "${BIN_PTHREADS:-./assign_1_1_framework/assign1_1}"
+  "${BIN_OMP:-./assign_1_2_framework/assign1_2}"
+)
+INIT="${INIT:-sinfull}"
+THREADS="${THREADS:-8}"
+SIZES=(100000 1000000 10000000 50000000)
+POINTS="${POINTS:-2000000000}"      # i_max * t_max per run
+CSV="${CSV:-results_nt.csv}"
+
+# -np 1 = single process; set RUN= to run directly on the current machine
+RUN="${RUN-prun -v -np 1}"
+
+extract_time() {
+  awk '/^Took /{t=$2} END{print t+0}'
+}
+
+for bin in "${BINS[@]}"; do
+  if [[ ! -x "$bin" ]]; then
+    echo "ERROR: binary not found or not executable: ${bin}" >&2
+    exit 1
+  fi
+done
+
+echo "binary,i_max,t_max,threads,stores,bytes_per_point,ns_per_point,gb_per_sec" > "$CSV"
+
+for bin in "${BINS[@]}"; do
+  for i_max in "${SIZES[@]}"; do
+    t_max=$(( POINTS / i_max ))
+    (( t_max < 1 )) && t_max=1
+    for mode in off on; do
+      echo "== $(basename "$bin") i_max=${i_max} t_max=${t_max} WAVE_NT=${mode} =="
+      out="$(WAVE_NT="$mode" $RUN "$bin" "$i_max" "$t_max" "$THREADS" "$INIT" 2>&1 \
+             | tee /dev/stderr)"
+      time_sec="$(printf "%s\n" "$out" | extract_time || true)"
+      if [[ -z "${time_sec}" || "${time_sec}" == "0" ]]; then
+        echo "  WARNING: couldn't parse time; skipping." >&2
+        continue
+      fi
+      # the solver reports the mode it actually used (scalar has no NT path)
+      if grep -q '^Streaming stores: on' <<<"$out"; then
+        stores=nt; bytes=24
+      else
+        stores=regular; bytes=32
+      fi
+      python3 - "$bin" "$i_max" "$t_max" "$THREADS" "$stores" "$bytes" "$time_sec" >> "$CSV" <<'PY'
+import sys
+b, i_max, t_max, thr, stores, nbytes, sec = sys.argv[1:]
+pts = (int(i_max) - 2) * int(t_max)
+ns = float(sec) * 1e9 / pts
+print(f"{b.split('/')[-1]},{i_max},{t_max},{thr},{stores},{nbytes},"
+      f"{ns:.4f},{int(nbytes) / ns:.2f}")
+PY
+    done
+  done
+done
+
+echo "Wrote ${CSV}"
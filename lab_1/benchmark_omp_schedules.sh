@@ -9,16 +9,17 @@ INIT="${INIT:-sinfull}"
 
 # What schedules to test:
 #   - add/remove as you like. Each entry is "env_value  tag"
+#   - chunk sizes count 64-point kernel blocks; tags give the size in points
 SCHEDULES=(
-  "static,4096     static4k"
-  "static,16384    static16k"
-  "static,65536    static65k"
-  "dynamic,1024    dynamic1k"
-  "dynamic,4096    dynamic4k"
-  "dynamic,16384   dynamic16k"
-  "guided,1024     guided1k"
-  "guided,4096     guided4k"
-  "guided,16384    guided16k"
+  "static,64       static4k"
+  "static,256      static16k"
+  "static,1024     static65k"
+  "dynamic,16      dynamic1k"
+  "dynamic,64      dynamic4k"
+  "dynamic,256     dynamic16k"
+  "guided,16       guided1k"
+  "guided,64       guided4k"
+  "guided,256      guided16k"
 )
 
 # CSV basename (files become results_<tag>.csv)
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# End-to-end job latency: assign1_1 started once per job (process startup,
+# allocation, thread creation, result.txt) against jobs sent to a running
+# `assign1_1 --serve' over its Unix socket, one per connection and in
+# rounds of INFLIGHT that the server batches.
+
+# ---- CONFIG (edit here or override via env) ----
+DIR="${DIR:-./assign_1_1_framework}"
+THREADS="${THREADS:-1}"
+INIT="${INIT:-sin}"
+JOBS="${JOBS:-30}"
+INFLIGHT="${INFLIGHT:-16}"
+CASES=(${CASES:-1000:100 1000:1000 100000:100 1000000:100})
+SOCK="${SOCK:-/tmp/wave-$$.sock}"
+CSV="${CSV:-results_server.csv}"
+
+for bin in assign1_1 wave_client; do
+  if [[ ! -x "$DIR/$bin" ]]; then
+    echo "ERROR: binary not found or not executable: $DIR/$bin" >&2
+    exit 1
+  fi
+done
+
+out="$PWD/$CSV"
+work=$(mktemp -d)
+server=
+trap 'if [[ -n "$server" ]]; then kill "$server"; fi; rm -rf "$work"' EXIT
+cp "$DIR/assign1_1" "$DIR/wave_client" "$work"
+cd "$work"
+
+./assign1_1 --serve="$SOCK" "$THREADS" > server.log 2>&1 &
+server=$!
+while [[ ! -S "$SOCK" ]]; do sleep 0.1; done
+
+median() { sort -g | awk '{a[NR] = $1} END {print a[int((NR + 1) / 2)]}'; }
+
+echo "i_max,t_max,cli_ms,server_ms,server_batched_ms" > "$out"
+for c in "${CASES[@]}"; do
+  i_max=${c%:*}
+  t_max=${c#*:}
+
+  cli=$(for ((k = 0; k < JOBS; ++k)); do
+          start=$(date +%s%N)
+          ./assign1_1 "$i_max" "$t_max" "$THREADS" "$INIT" > /dev/null 2>&1
+          echo $(( $(date +%s%N) - start ))
+        done | awk '{print $1 / 1e6}' | median)
+  one=$(./wave_client "$SOCK" "$i_max" "$t_max" "$INIT" "$JOBS" 1 \
+        | awk '/^Latency/ {print $6}')
+  many=$(./wave_client "$SOCK" "$i_max" "$t_max" "$INIT" "$JOBS" "$INFLIGHT" \
+         | awk -v n="$INFLIGHT" '/^Latency/ {print $6 / n}')
+
+  echo "i_max=$i_max t_max=$t_max: CLI $cli ms, server $one ms," \
+       "$INFLIGHT in flight $many ms per job"
+  echo "$i_max,$t_max,$cli,$one,$many" >> "$out"
+done
+
+echo "Wrote $out"
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# OpenMP block loop (omp for + omp single, two barriers per step, under
+# each OMP_SCHEDULE) vs WAVE_SCHED=static (parity-indexed buffers, static
+# cache-line chunks, one barrier per step), for small waves where the
+# barriers dominate and large ones where memory bandwidth does.
+# Every run does about POINTS point updates, so t_max shrinks as i_max grows.
+
+# ---- CONFIG (edit here or override via env) ----
+BIN="${BIN:-./assign_1_2_framework/assign1_2}"
+INIT="${INIT:-sinfull}"
+THREADS=(${THREADS:-1 2 4 8})
+SIZES=(${SIZES:-1000 10000 1000000 10000000})
+SCHEDULES=(${SCHEDULES:-static dynamic,4 guided})
+POINTS="${POINTS:-2000000000}"     # i_max * t_max per run
+CSV="${CSV:-results_static.csv}"
+
+# -np 1 = single process; set RUN= to run directly on the current machine
+RUN="${RUN-prun -v -np 1}"
+
+extract_time() {
+  awk '/^Took /{t=$2} END{print t+0}'
+}
+
+if [[ ! -x "$BIN" ]]; then
+  echo "ERROR: binary not found or not executable: ${BIN}" >&2
+  exit 1
+fi
+
+echo "i_max,t_max,threads,mode,time_sec,ns_per_point" > "$CSV"
+
+for i_max in "${SIZES[@]}"; do
+  t_max=$(( POINTS / i_max ))
+  (( t_max < 1 )) && t_max=1
+  for nthr in "${THREADS[@]}"; do
+    for mode in "${SCHEDULES[@]}" single-barrier; do
+      echo "== i_max=${i_max} t_max=${t_max} threads=${nthr} ${mode} =="
+      if [[ "$mode" == single-barrier ]]; then
+        env=(WAVE_SCHED=static)
+      else
+        env=(OMP_SCHEDULE="$mode")
+      fi
+      out="$(env "${env[@]}" $RUN "$BIN" "$i_max" "$t_max" "$nthr" "$INIT" 2>&1 \
+             | tee /dev/stderr)"
+      time_sec="$(printf "%s\n" "$out" | extract_time || true)"
+      if [[ -z "${time_sec}" || "${time_sec}" == "0" ]]; then
+        echo "  WARNING: couldn't parse time; skipping." >&2
+        continue
+      fi
+      ns=$(awk -v s="$time_sec" -v n="$i_max" -v t="$t_max" \
+             'BEGIN { print s * 1e9 / ((n - 2) * t) }')
+      printf "%s,%s,%s,\"%s\",%s,%.4f\n" "$i_max" "$t_max" "$nthr" "$mode" \
+        "$time_sec" "$ns" >> "$CSV"
+    done
+  done
+done
+
+echo "Wrote ${CSV}"
@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Whole-sweep wall time: one process per run, one after the other (what
+# test_ampl.sh, test_amp_openmp.sh and benchmark_prun.sh do), against the
+# in-process sweep runner, which packs the same runs onto disjoint cores.
+# Both sweep the same backends, sizes and thread counts; the per-run times
+# land in loop.csv and sweep.csv for comparison.
+
+# ---- CONFIG (edit here or override via env) ----
+WAVE="${WAVE:-./wave/wave}"
+SWEEP="${SWEEP:-./sweep/sweep}"
+BACKENDS=(${BACKENDS:-pthreads omp})
+SIZES=(${SIZES:-1000 10000 100000 1000000})
+THREADS=(${THREADS:-1 2 4})
+STEPS="${STEPS:-1000}"
+INIT="${INIT:-sinfull}"
+SPEC="${SPEC:-bench.spec}"
+
+for bin in "$WAVE" "$SWEEP"; do
+  if [[ ! -x "$bin" ]]; then
+    echo "ERROR: binary not found or not executable: ${bin}" >&2
+    exit 1
+  fi
+done
+
+now() { date +%s.%N; }
+
+echo "backend,N,steps,threads,raw_time" > loop.csv
+start=$(now)
+for be in "${BACKENDS[@]}"; do
+  for n in "${SIZES[@]}"; do
+    for t in "${THREADS[@]}"; do
+      took=$("$WAVE" --backend="$be" "$n" "$STEPS" "$t" "$INIT" 2>/dev/null \
+             | awk '/^Took /{print $2}')
+      echo "$be,$n,$STEPS,$t,$took" >> loop.csv
+    done
+  done
+done
+loop=$(awk -v a="$start" -v b="$(now)" 'BEGIN{print b - a}')
+
+join() { local IFS=,; echo "$*"; }
+echo "backend=$(join "${BACKENDS[@]}") i_max=$(join "${SIZES[@]}")" \
+     "t_max=$STEPS threads=$(join "${THREADS[@]}") init=$INIT" > "$SPEC"
+start=$(now)
+"$SWEEP" "$SPEC" sweep.csv > /dev/null 2>&1
+sweep=$(awk -v a="$start" -v b="$(now)" 'BEGIN{print b - a}')
+
+printf "process per run: %.2f s\n" "$loop"
+printf "sweep runner:    %.2f s\n" "$sweep"
@@ -0,0 +1,60 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Step-by-step sweep vs the cache-oblivious trapezoid traversal
+# (WAVE_SCHED=trap) for both lab_1 solvers, over i_max = 1e3 .. 1e8.
+# Every run does about POINTS point updates, so t_max shrinks as i_max
+# grows; the trapezoids need enough steps to reuse what they load, so keep
+# POINTS large enough that the biggest size still runs a few hundred steps.
+
+# ---- CONFIG (edit here or override via env) ----
+BINS=(
+  "${BIN_PTHREADS:-./assign_1_1_framework/assign1_1}"
+  "${BIN_OMP:-./assign_1_2_framework/assign1_2}"
+)
+INIT="${INIT:-sinfull}"
+THREADS=(1 8)
+SIZES=(1000 10000 100000 1000000 10000000 100000000)
+POINTS="${POINTS:-20000000000}"     # i_max * t_max per run
+CSV="${CSV:-results_trap.csv}"
+
+# -np 1 = single process; set RUN= to run directly on the current machine
+RUN="${RUN-prun -v -np 1}"
+
+extract_time() {
+  awk '/^Took /{t=$2} END{print t+0}'
+}
+
+for bin in "${BINS[@]}"; do
+  if [[ ! -x "$bin" ]]; then
+    echo "ERROR: binary not found or not executable: ${bin}" >&2
+    exit 1
+  fi
+done
+
+echo "binary,i_max,t_max,threads,mode,time_sec,ns_per_point" > "$CSV"
+
+for bin in "${BINS[@]}"; do
+  for i_max in "${SIZES[@]}"; do
+    t_max=$(( POINTS / i_max ))
+    (( t_max < 1 )) && t_max=1
+    for nthr in "${THREADS[@]}"; do
+      for mode in sweep trap; do
+        echo "== $(basename "$bin") i_max=${i_max} t_max=${t_max} threads=${nthr} ${mode} =="
+        out="$(WAVE_SCHED="$mode" $RUN "$bin" "$i_max" "$t_max" "$nthr" "$INIT" 2>&1 \
+               | tee /dev/stderr)"
+        time_sec="$(printf "%s\n" "$out" | extract_time || true)"
+        if [[ -z "${time_sec}" || "${time_sec}" == "0" ]]; then
+          echo "  WARNING: couldn't parse time; skipping." >&2
+          continue
+        fi
+        ns=$(awk -v s="$time_sec" -v n="$i_max" -v t="$t_max" \
+               'BEGIN { print s * 1e9 / ((n - 2) * t) }')
+        printf "%s,%s,%s,%s,%s,%s,%.4f\n" "$(basename "$bin")" "$i_max" \
+          "$t_max" "$nthr" "$mode" "$time_sec" "$ns" >> "$CSV"
+      done
+    done
+  done
+done
+
+echo "Wrote ${CSV}"
@@ -0,0 +1,137 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+# Bitwise regression check for the lab_1 solvers. Thread counts, solver
+# modes, backends and server batching only change which thread computes
+# which points, so every run of a case must write exactly the result of
+# the one-thread pthreads run, compared as raw doubles (WAVE_RESULT_RAW).
+# Prints one line per run and exits non-zero if any differ or fail.
+# WAVE_KERNEL=scalar|sse2|avx2|avx512 in the environment checks that kernel.
+
+# ---- CONFIG (edit here or override via env) ----
+PTHREADS="${BIN_PTHREADS:-./assign_1_1_framework/assign1_1}"
+OMP="${BIN_OMP:-./assign_1_2_framework/assign1_2}"
+CLIENT="${BIN_CLIENT:-./assign_1_1_framework/wave_client}"
+CASES=(${CASES:-1003:200:sinfull 4099:300:sin 20011:60:gauss})
+THREADS=(${THREADS:-1 2 3 5 8})
+# server jobs, small enough to batch (WAVE_SERVE_BATCH)
+SERVER_CASES=(${SERVER_CASES:-577:500:sinfull 1003:200:sinfull
+                              4091:300:sinfull 1003:200:gauss})
+# solver modes as BACKEND:VAR=VALUE[,VAR=VALUE...], BACKEND pthreads, omp
+# or both; each is checked at every thread count against the same reference
+MODES=(${MODES:-both:WAVE_NT=on both:WAVE_NT=off
+                pthreads:WAVE_TBLOCK=7 pthreads:WAVE_TBLOCK=auto
+                both:WAVE_WINDOW=off
+                pthreads:WAVE_SCHED=steal
+                pthreads:WAVE_SCHED=steal,WAVE_CHUNK=37
+                both:WAVE_SCHED=trap omp:WAVE_SCHED=static})
+
+for bin in "$PTHREADS" "$OMP"; do
+  if [[ ! -x "$bin" ]]; then
+    echo "ERROR: binary not found or not executable: ${bin}" >&2
+    exit 1
+  fi
+done
+PTHREADS=$(realpath "$PTHREADS")
+OMP=$(realpath "$OMP")
+
+work=$(mktemp -d)
+server=
+trap 'if [[ -n "$server" ]]; then kill "$server"; fi; rm -rf "$work"' EXIT
+failed=0
+
+# run BIN I_MAX T_MAX THREADS INIT [VAR=VALUE ...]: prints the result's hash
+run() {
+  local bin=$1 i_max=$2 t_max=$3 nthr=$4 init=$5
+  shift 5
+  (cd "$work" && rm -f result.raw \
+     && env WAVE_RESULT_RAW=result.raw "$@" \
+          "$bin" "$i_max" "$t_max" "$nthr" "$init" > /dev/null 2>&1 \
+     && md5sum < result.raw | cut -d' ' -f1) || echo "error"
+}
+
+# run_client SOCKET I_MAX T_MAX INIT INFLIGHT: sends INFLIGHT jobs in one
+# round, which the server batches, and prints the last reply's hash
+run_client() {
+  local sock=$1 i_max=$2 t_max=$3 init=$4 inflight=$5
+  (cd "$work" && rm -f reply.raw \
+     && WAVE_RESULT_RAW=reply.raw "$CLIENT" "$sock" "$i_max" "$t_max" \
+          "$init" "$inflight" "$inflight" > /dev/null 2>&1 \
+     && md5sum < reply.raw | cut -d' ' -f1) || echo "error"
+}
+
+# check LABEL REF RUNNER [ARGS ...]: compares the hash RUNNER prints
+check() {
+  local label=$1 ref=$2 got
+  shift 2
+  got=$("$@")
+  if [[ "$got" == "$ref" && "$got" != error ]]; then
+    echo "ok      $label"
+  else
+    echo "DIFFERS $label"
+    failed=1
+  fi
+}
+
+for c in "${CASES[@]}"; do
+  IFS=: read -r i_max t_max init <<< "$c"
+  awk -v n="$i_max" 'BEGIN { for (i = 0; i < n; i++)
+                               printf "%.17g\n", 0.05 + 0.1 * i / n }' \
+    > "$work/coef-$i_max.txt"
+
+  # the stencils: second order, fourth order and a varying c
+  for stencil in "" "WAVE_ORDER=4" "WAVE_COEFF=$work/coef-$i_max.txt"; do
+    vars=(${stencil})
+    name="${stencil%%=*}"
+    name="${name:-order2}"
+    ref=$(run "$PTHREADS" "$i_max" "$t_max" 1 "$init" "${vars[@]}")
+
+    for nthr in "${THREADS[@]}"; do
+      check "$c $name pthreads threads=$nthr" "$ref" \
+        run "$PTHREADS" "$i_max" "$t_max" "$nthr" "$init" "${vars[@]}"
+      check "$c $name omp threads=$nthr" "$ref" \
+        run "$OMP" "$i_max" "$t_max" "$nthr" "$init" "${vars[@]}"
+    done
+
+    for mode in "${MODES[@]}"; do
+      backend="${mode%%:*}"
+      IFS=, read -r -a menv <<< "${mode#*:}"
+      for nthr in "${THREADS[@]}"; do
+        if [[ "$backend" != omp ]]; then
+          check "$c $name pthreads ${mode#*:} threads=$nthr" "$ref" \
+            run "$PTHREADS" "$i_max" "$t_max" "$nthr" "$init" "${vars[@]}" \
+            "${menv[@]}"
+        fi
+        if [[ "$backend" != pthreads ]]; then
+          check "$c $name omp ${mode#*:} threads=$nthr" "$ref" \
+            run "$OMP" "$i_max" "$t_max" "$nthr" "$init" "${vars[@]}" \
+            "${menv[@]}"
+        fi
+      done
+    done
+  done
+done
+
+# The server runs a job alone (the solver context) or, with others of the
+# same size in its round, through simulate_batch(); both replies must match
+# the second-order reference. Five jobs leave a partial vector in the batch
+# kernel. sin and gauss jobs mostly run alone because of their small active
+# window, so sinfull is what exercises the batches.
+if [[ -x "$CLIENT" ]]; then
+  CLIENT=$(realpath "$CLIENT")
+  sock="$work/wave.sock"
+  "$PTHREADS" --serve="$sock" 3 > "$work/server.log" 2>&1 &
+  server=$!
+  while [[ ! -S "$sock" ]]; do sleep 0.1; done
+
+  for c in "${SERVER_CASES[@]}"; do
+    IFS=: read -r i_max t_max init <<< "$c"
+    ref=$(run "$PTHREADS" "$i_max" "$t_max" 1 "$init")
+    for inflight in 1 5 8; do
+      check "$c server inflight=$inflight" "$ref" \
+        run_client "$sock" "$i_max" "$t_max" "$init" "$inflight"
+    done
+  done
+fi
+
+exit $failed
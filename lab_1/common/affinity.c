@@ -0,0 +1,193 @@
+/*
+ * affinity.c
+ *
+ * Thread pinning and NUMA placement helpers. Topology comes from sysfs and
+ * page placement from move_pages(2), so no libnuma is needed.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "affinity.h"
+
+#define MAX_NODES 64
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static int *cpus;        /* pinning order, NULL when pinning is off */
+static int ncpus;
+
+/* CPU currently pinned by this thread, so pool workers pin only once */
+static _Thread_local int pinned = -1;
+
+/* Parses a cpulist such as "0-3,8,10-11" and calls add() for every CPU. */
+static void parse_cpulist(const char *s, void (*add)(int cpu, void *ctx),
+        void *ctx)
+{
+    while (*s) {
+        char *endp;
+        long a = strtol(s, &endp, 10), b = a;
+        if (endp == s)
+            break;
+        if (*endp == '-')
+            b = strtol(endp + 1, &endp, 10);
+        for (long c = a; c <= b; ++c)
+            add((int)c, ctx);
+        s = (*endp == ',') ? endp + 1 : endp;
+        if (*s == '\n')
+            break;
+    }
+}
+
+typedef struct {
+    int *list;
+    int n;
+    int cap;
+    const cpu_set_t *allowed;
+} cpu_list_t;
+
+static void add_cpu(int cpu, void *ctx)
+{
+    cpu_list_t *l = ctx;
+    if (cpu < 0 || cpu >= CPU_SETSIZE || l->n >= l->cap)
+        return;
+    if (l->allowed && !CPU_ISSET(cpu, l->allowed))
+        return;
+    l->list[l->n++] = cpu;
+}
+
+/* Reads the allowed CPUs of NUMA node `node' into l. Returns -1 when the
+   node does not exist. */
+static int node_cpus(int node, cpu_list_t *l)
+{
+    char path[64], buf[4096];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    if (!fgets(buf, sizeof(buf), fp))
+        buf[0] = '\0';
+    fclose(fp);
+
+    parse_cpulist(buf, add_cpu, l);
+    return 0;
+}
+
+static void init_policy(void)
+{
+    const char *env = getenv("WAVE_AFFINITY");
+    cpu_set_t allowed;
+
+    if (!env || !*env)
+        return;
+
+    cpus = malloc(sizeof(int) * CPU_SETSIZE);
+    if (!cpus)
+        return;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        CPU_ZERO(&allowed);
+
+    if (strcmp(env, "compact") == 0 || strcmp(env, "scatter") == 0) {
+        int *node_list[MAX_NODES], node_n[MAX_NODES], nnodes = 0;
+
+        for (int node = 0; node < MAX_NODES; ++node) {
+            cpu_list_t l = { malloc(sizeof(int) * CPU_SETSIZE), 0,
+                             CPU_SETSIZE, &allowed };
+            if (!l.list || node_cpus(node, &l) != 0) {
+                free(l.list);
+                break;
+            }
+            node_list[nnodes] = l.list;
+            node_n[nnodes++] = l.n;
+        }
+
+        if (nnodes == 0) {
+            /* no sysfs topology: treat all allowed CPUs as one node */
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &allowed))
+                    cpus[ncpus++] = c;
+        } else if (env[0] == 'c') {
+            for (int node = 0; node < nnodes; ++node)
+                for (int i = 0; i < node_n[node]; ++i)
+                    cpus[ncpus++] = node_list[node][i];
+        } else {
+            for (int i = 0, added = 1; added; ++i) {
+                added = 0;
+                for (int node = 0; node < nnodes; ++node) {
+                    if (i < node_n[node]) {
+                        cpus[ncpus++] = node_list[node][i];
+                        added = 1;
+                    }
+                }
+            }
+        }
+
+        for (int node = 0; node < nnodes; ++node)
+            free(node_list[node]);
+    } else {
+        cpu_list_t l = { cpus, 0, CPU_SETSIZE, NULL };
+        parse_cpulist(env, add_cpu, &l);
+        ncpus = l.n;
+    }
+
+    if (ncpus == 0) {
+        fprintf(stderr, "WAVE_AFFINITY=%s matches no CPU; not pinning.\n",
+                env);
+        free(cpus);
+        cpus = NULL;
+    }
+}
+
+int affinity_cpu(int tid)
+{
+    pthread_once(&once, init_policy);
+    if (!cpus)
+        return -1;
+    return cpus[tid % ncpus];
+}
+
+int affinity_pin(int tid)
+{
+    int cpu = affinity_cpu(tid);
+    cpu_set_t set;
+
+    if (cpu < 0 || cpu == pinned)
+        return cpu;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        fprintf(stderr, "Could not pin thread %d to CPU %d.\n", tid, cpu);
+        return -1;
+    }
+    pinned = cpu;
+    return cpu;
+}
+
+int affinity_node_of(const void *addr)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    void *pages[1];
+    int status[1] = { -1 };
+
+    pages[0] = (void *)((unsigned long)addr & ~((unsigned long)page - 1));
+    if (syscall(SYS_move_pages, 0, 1UL, pages, NULL, status, 0) != 0)
+        return -1;
+    return status[0] >= 0 ? status[0] : -1;
+}
+
+int affinity_first_touch(void)
+{
+    const char *env = getenv("WAVE_FIRST_TOUCH");
+    return env && *env && strcmp(env, "0") != 0;
+}
@@ -0,0 +1,28 @@
+/*
+ * affinity.h
+ *
+ * Thread pinning and NUMA placement helpers for the lab_1 solvers.
+ *
+ * WAVE_AFFINITY selects the pinning policy:
+ *   compact   fill the CPUs of one NUMA node before moving to the next
+ *   scatter   round-robin threads over the NUMA nodes
+ *   <list>    explicit CPU list, e.g. "0,2,4,6" or "0-7,16-23"
+ * Unset means threads are not pinned.
+ */
+
+#pragma once
+
+/* CPU thread tid should be pinned to, or -1 when pinning is off. */
+int affinity_cpu(int tid);
+
+/* Pins the calling thread to the CPU affinity_cpu(tid) picks (no-op when
+   pinning is off or the thread already sits there). Returns that CPU. */
+int affinity_pin(int tid);
+
+/* NUMA node of the page holding addr, or -1 when it is unknown or the page
+   was never touched. */
+int affinity_node_of(const void *addr);
+
+/* Non-zero when WAVE_FIRST_TOUCH asks workers to initialize their own
+   partition of the arrays. */
+int affinity_first_touch(void);
@@ -0,0 +1,205 @@
+/*
+ * arena.c
+ *
+ * Huge-page arena for the solver buffers, see arena.h. Huge page coverage
+ * of a transparent mapping is read from /proc/self/smaps and the dTLB
+ * counter comes from perf_event_open(2); both are optional.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "arena.h"
+
+#define HUGE_SIZE (2UL << 20)
+
+enum { ARENA_NONE, ARENA_HUGETLB, ARENA_THP, ARENA_SMALL };
+
+static const char *kind_name[] = { "none", "hugetlb", "thp", "small pages" };
+
+static size_t round_up(size_t n, size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+/* 0 = huge, 1 = thp, 2 = off */
+static int arena_mode(void)
+{
+    const char *env = getenv("WAVE_ARENA");
+
+    if (!env || !*env || strcmp(env, "huge") == 0)
+        return 0;
+    if (strcmp(env, "thp") == 0)
+        return 1;
+    return 2;
+}
+
+static int stats_on(void)
+{
+    const char *env = getenv("WAVE_ARENA_STATS");
+    return env && *env && strcmp(env, "0") != 0;
+}
+
+/* Counter of dTLB load misses of this thread and the ones it starts. */
+static int tlb_open(void)
+{
+    struct perf_event_attr pe;
+
+    memset(&pe, 0, sizeof(pe));
+    pe.size = sizeof(pe);
+    pe.type = PERF_TYPE_HW_CACHE;
+    pe.config = PERF_COUNT_HW_CACHE_DTLB
+              | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    pe.inherit = 1;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+/* Maps cap bytes aligned to HUGE_SIZE, trimming an oversized mapping. */
+static char *map_aligned(size_t cap)
+{
+    size_t len = cap + HUGE_SIZE;
+    char *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    char *q = (char *)round_up((uintptr_t)p, HUGE_SIZE);
+    if (q > p)
+        munmap(p, q - p);
+    if (p + len > q + cap)
+        munmap(q + cap, p + len - (q + cap));
+    return q;
+}
+
+int wave_arena_reserve(wave_arena_t *a, size_t bytes)
+{
+    if (a->base && a->cap >= bytes) {
+        wave_arena_reset(a);
+        return 0;
+    }
+    wave_arena_release(a);
+
+    const int mode = arena_mode();
+    size_t cap = round_up(bytes > 0 ? bytes : 1, HUGE_SIZE);
+    char *p = NULL;
+
+    if (mode == 0) {
+        p = mmap(NULL, cap, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED)
+            p = NULL;
+        else
+            a->kind = ARENA_HUGETLB;
+    }
+    if (!p) {
+        p = map_aligned(cap);
+        if (!p)
+            return -1;
+        a->kind = ARENA_SMALL;
+#ifdef MADV_HUGEPAGE
+        if (mode < 2 && madvise(p, cap, MADV_HUGEPAGE) == 0)
+            a->kind = ARENA_THP;
+#endif
+    }
+
+    a->base = p;
+    a->cap = cap;
+    a->used = 0;
+    a->page = (a->kind == ARENA_SMALL) ? (size_t)sysconf(_SC_PAGESIZE)
+                                       : HUGE_SIZE;
+    if (stats_on() && !a->tlb_fd)
+        a->tlb_fd = tlb_open() + 1;
+    return 0;
+}
+
+void *wave_arena_alloc(wave_arena_t *a, size_t bytes, size_t lead)
+{
+    if (!a->base)
+        return NULL;
+
+    size_t off = round_up(a->used + lead, WAVE_ARENA_LINE) - lead;
+    if (off < a->used)
+        off += WAVE_ARENA_LINE;
+    if (off + bytes > a->cap)
+        return NULL;
+
+    a->used = off + bytes;
+    return a->base + off;
+}
+
+void wave_arena_reset(wave_arena_t *a)
+{
+    /* a reused arena must hand out zeroed memory like a fresh mapping */
+    if (a->base && a->used > 0)
+        memset(a->base, 0, a->used);
+    a->used = 0;
+}
+
+void wave_arena_release(wave_arena_t *a)
+{
+    if (a->base)
+        munmap(a->base, a->cap);
+    a->base = NULL;
+    a->cap = 0;
+    a->used = 0;
+    a->kind = ARENA_NONE;
+    if (a->tlb_fd > 0)
+        close(a->tlb_fd - 1);
+    a->tlb_fd = 0;
+}
+
+/* kB of the mapping at base backed by transparent huge pages, or -1. */
+static long thp_kb(const char *base)
+{
+    FILE *f = fopen("/proc/self/smaps", "r");
+    char line[256];
+    int in = 0;
+    long kb = -1;
+
+    if (!f)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            if (in)
+                break;
+            in = (start == (uintptr_t)base);
+        } else if (in && sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+    return kb;
+}
+
+void wave_arena_report(const wave_arena_t *a, const char *who)
+{
+    if (!stats_on() || !a->base)
+        return;
+
+    fprintf(stderr, "%s arena: %zu kB, %s, page size %zu kB",
+            who, a->cap >> 10, kind_name[a->kind], a->page >> 10);
+    if (a->kind == ARENA_THP) {
+        long kb = thp_kb(a->base);
+        if (kb >= 0)
+            fprintf(stderr, ", %ld kB on huge pages", kb);
+    }
+
+    long long misses;
+    if (a->tlb_fd > 0 &&
+            read(a->tlb_fd - 1, &misses, sizeof(misses)) == sizeof(misses))
+        fprintf(stderr, ", dTLB load misses %lld\n", misses);
+    else
+        fprintf(stderr, ", dTLB counter not available\n");
+}
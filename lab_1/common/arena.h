@@ -0,0 +1,60 @@
+/*
+ * arena.h
+ *
+ * Bump allocator for the solver buffers. One mapping, aligned to 2 MB,
+ * holds all arrays of a run so that large waves sit on huge pages: first
+ * MAP_HUGETLB is tried, then an ordinary mapping with
+ * madvise(MADV_HUGEPAGE) for transparent huge pages. Every allocation
+ * starts on a cache line, or `lead' bytes before one so that the element
+ * after a halo is aligned. Nothing is freed one by one: reset the arena to
+ * reuse the mapping for the next run, or release it.
+ *
+ * WAVE_ARENA selects the backing:
+ *   huge   MAP_HUGETLB, falling back to thp (default)
+ *   thp    transparent huge pages only
+ *   off    ordinary pages, for comparison
+ * WAVE_ARENA_STATS=1 makes wave_arena_report() print the backing, the share
+ * of the arena on huge pages and the dTLB load misses counted since the
+ * mapping was made (perf_event_open; only threads started after that are
+ * counted, and only once they exit).
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#define WAVE_ARENA_LINE 64
+
+/* Worst-case arena space an allocation of `bytes' takes. */
+#define WAVE_ARENA_CHUNK(bytes) ((size_t)(bytes) + 2 * WAVE_ARENA_LINE)
+
+/* A zero-initialized arena is valid and empty. */
+typedef struct {
+    char *base;
+    size_t cap;     /* mapped bytes, a multiple of the page size */
+    size_t used;
+    size_t page;    /* page size of the mapping */
+    int kind;       /* how the mapping is backed, see arena.c */
+    int tlb_fd;     /* dTLB miss counter + 1, 0 if there is none */
+} wave_arena_t;
+
+/*
+ * Makes room for `bytes' of allocations and drops the earlier ones. The
+ * mapping is kept when it is large enough, so the pages stay faulted in
+ * across runs. Returns 0, or -1 when nothing could be mapped.
+ */
+int wave_arena_reserve(wave_arena_t *a, size_t bytes);
+
+/* Zeroed memory of `bytes' with (p + lead) on a cache line, or NULL when
+   the reservation is used up. */
+void *wave_arena_alloc(wave_arena_t *a, size_t bytes, size_t lead);
+
+/* Drops all allocations but keeps the mapping. */
+void wave_arena_reset(wave_arena_t *a);
+
+/* Unmaps the arena; it is empty again afterwards. */
+void wave_arena_release(wave_arena_t *a);
+
+/* With WAVE_ARENA_STATS set, prints the page size, huge-page coverage and
+   dTLB misses to stderr, prefixed by who. */
+void wave_arena_report(const wave_arena_t *a, const char *who);
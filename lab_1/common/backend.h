@@ -0,0 +1,48 @@
+/*
+ * backend.h
+ *
+ * Solver table of the lab_1 drivers. Every solver registers itself with a
+ * wave_backend_t, and a driver picks one at run time with --backend=NAME
+ * (see driver.h), so all solvers run behind the same setup, timing and
+ * output code.
+ */
+
+#pragma once
+
+#include "wave_ctx.h"
+
+typedef struct {
+    const char *name;
+    const char *desc;
+
+    /* Same contract as simulate(): next_array may be NULL for the in-place
+       update, and the array holding generation t_max is returned. */
+    double *(*run)(int i_max, int t_max, int num_threads,
+            double *old_array, double *current_array, double *next_array);
+
+    /* Zeroes the arrays the way the solver will touch them (NUMA first
+       touch), or NULL when a plain memset does. */
+    void (*first_touch)(int i_max, int num_threads, double *old_array,
+            double *current_array, double *next_array);
+
+    /* Non-zero if the solver honours WAVE_PRECISION; the others always
+       compute in double. */
+    int reduced_precision;
+
+    /* The solver's wave_ctx API (wave_ctx.h), for drivers that need the
+       generations in between; all NULL when the solver only has run. */
+    wave_ctx_t *(*ctx_create)(int i_max, int num_threads, double *old_array,
+            double *current_array, double *next_array);
+    int (*step)(wave_ctx_t *ctx, int n);
+    const double *(*view)(const wave_ctx_t *ctx, const double **prev);
+    void (*destroy)(wave_ctx_t *ctx);
+} wave_backend_t;
+
+/* Single-threaded solvers in sequential.c: "seq" is the tuned scalar
+   reference, "simd" runs the vector kernel of wave_kernel_select(). */
+extern const wave_backend_t wave_backend_seq;
+extern const wave_backend_t wave_backend_simd;
+
+/* The threaded solvers, defined next to their simulate(). */
+extern const wave_backend_t wave_backend_pthreads;
+extern const wave_backend_t wave_backend_omp;
@@ -0,0 +1,61 @@
+/*
+ * coeff.c
+ *
+ * Loads the coefficient array of WAVE_COEFF, see coeff.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "coeff.h"
+#include "wave_kernels.h"
+
+static double *coef;
+static int coef_n = -1;   /* i_max the array was read for */
+
+const double *wave_coeff(int i_max)
+{
+    const char *path = getenv("WAVE_COEFF");
+    int uniform = 1;
+    void *mem = NULL;
+    FILE *fp;
+
+    if (!path || !*path)
+        return NULL;
+    if (coef_n == i_max)
+        return coef;
+
+    free(coef);
+    coef = NULL;
+    coef_n = i_max;
+
+    if (!(fp = fopen(path, "r"))) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    if (posix_memalign(&mem, 64, sizeof(double) * (size_t)i_max) != 0) {
+        fprintf(stderr, "Coefficient allocation failed.\n");
+        exit(EXIT_FAILURE);
+    }
+    coef = mem;
+    for (int i = 0; i < i_max; ++i) {
+        if (fscanf(fp, "%lf", &coef[i]) != 1) {
+            fprintf(stderr, "%s: expected %d coefficients, found %d.\n",
+                    path, i_max, i);
+            exit(EXIT_FAILURE);
+        }
+        if (i > 0 && i < i_max - 1 && coef[i] != C_CONST)
+            uniform = 0;
+    }
+    fclose(fp);
+
+    if (uniform) {
+        fprintf(stderr, "Coefficients: uniform %g, constant kernel\n",
+                C_CONST);
+        free(coef);
+        coef = NULL;
+    } else {
+        fprintf(stderr, "Coefficients: %s\n", path);
+    }
+    return coef;
+}
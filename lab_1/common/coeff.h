@@ -0,0 +1,23 @@
+/*
+ * coeff.h
+ *
+ * Spatially varying wave speed for the lab_1 solvers. WAVE_COEFF=<file>
+ * reads one coefficient per line, i_max lines in the format of the initial
+ * data files, and point i is then updated with coef[i] in place of C_CONST
+ * (coef[i] = (v(x_i) dt / dx)^2, so it must stay within (0, 1] for the
+ * scheme to be stable). The end points keep their fixed zero, whatever
+ * their coefficient.
+ *
+ * A file that holds C_CONST everywhere, like no file, leaves the solvers on
+ * the constant kernels; any other file costs one more read stream per
+ * point (see ../benchmark_coeff.sh).
+ */
+
+#pragma once
+
+/*
+ * The coefficients for waves of i_max points, 64-byte aligned, or NULL
+ * when c is uniform. The file is read once and reported on stderr; a file
+ * that cannot be read exits the program.
+ */
+const double *wave_coeff(int i_max);
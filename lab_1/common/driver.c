@@ -0,0 +1,383 @@
+/*
+ * driver.c
+ *
+ * Contains code for setting up and finishing the simulation, for whichever
+ * solver is selected (see driver.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "affinity.h"
+#include "arena.h"
+#include "coeff.h"
+#include "driver.h"
+#include "file.h"
+#include "initial.h"
+#include "precision.h"
+#include "snapshot.h"
+#include "spectral.h"
+#include "timer.h"
+#include "wave_kernels.h"
+
+/* Most solvers one run may compare. */
+#define MAX_RUNS 16
+
+static void usage(const char *prog, const wave_backend_t *const backends[],
+        int nbackends)
+{
+    printf("Usage: %s [--backend=NAME] i_max t_max num_threads "
+            "[initial_data]\n", prog);
+    printf(" - i_max: number of discrete amplitude points, should be >2\n");
+    printf(" - t_max: number of discrete timesteps, should be >=1\n");
+    printf(" - num_threads: number of threads to use for simulation, "
+            "should be >=1\n");
+    printf(" - initial_data: select what data should be used for the first "
+            "two generation.\n");
+    printf("   Available options are:\n");
+    printf("    * sin: one period of the sinus function at the start.\n");
+    printf("    * sinfull: entire data is filled with the sinus.\n");
+    printf("    * gauss: a single gauss-function at the start.\n");
+    printf("    * file <2 filenames>: allows you to specify a file with on "
+            "each line a float for both generations.\n");
+    printf(" - --backend: solver to run (default %s); a comma-separated list "
+            "runs each on the same data.\n", backends[0]->name);
+    for (int b = 0; b < nbackends; ++b)
+        printf("    * %s: %s\n", backends[b]->name, backends[b]->desc);
+}
+
+/* Writes the n doubles of a as they are in memory (WAVE_RESULT_RAW), for
+   comparisons down to the last bit, which result.txt rounds away. */
+static void write_raw(const char *path, const double *a, int n)
+{
+    FILE *fp = fopen(path, "wb");
+
+    if (!fp || fwrite(a, sizeof(double), n, fp) != (size_t)n)
+        fprintf(stderr, "Could not write %s.\n", path);
+    if (fp)
+        fclose(fp);
+}
+
+/* Resolves the comma-separated names in list into sel. Returns how many,
+   or -1 after reporting an unknown name. */
+static int select_backends(const char *list,
+        const wave_backend_t *const backends[], int nbackends,
+        const wave_backend_t *sel[MAX_RUNS])
+{
+    int n = 0;
+
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        int b = 0;
+
+        while (b < nbackends && (strlen(backends[b]->name) != len ||
+                strncmp(backends[b]->name, list, len) != 0))
+            ++b;
+        if (b == nbackends) {
+            printf("Unknown backend: %.*s.\n", (int)len, list);
+            return -1;
+        }
+        if (n < MAX_RUNS)
+            sel[n++] = backends[b];
+        list += len;
+        if (*list == ',')
+            ++list;
+    }
+    return n;
+}
+
+/* Zeroes the buffers like the solver will touch them. */
+static void clear_buffers(const wave_backend_t *be, int i_max,
+        int num_threads, double *old, double *current, double *next)
+{
+    if (affinity_first_touch() && be->first_touch) {
+        /* Let every worker zero (and thereby place) its own partition. */
+        be->first_touch(i_max, num_threads, old, current, next);
+    } else {
+        memset(old, 0, i_max * sizeof(double));
+        memset(current, 0, i_max * sizeof(double));
+        if (next != NULL)
+            memset(next, 0, i_max * sizeof(double));
+    }
+}
+
+/*
+ * Runs be for t_max steps and hands every generation t that is a multiple
+ * of every to the snapshot writer. Solvers with the wave_ctx API keep
+ * their threads and state across the chunks; the others are rerun per
+ * chunk on the rotated buffers. Returns the array holding t_max.
+ */
+static double *run_snapshots(const wave_backend_t *be, wave_snap_t *snap,
+        int every, int i_max, int t_max, int num_threads, double *old,
+        double *current, double *next)
+{
+    double *bufs[3] = { old, current, next };
+    const int nbufs = next ? 3 : 2;
+    wave_ctx_t *ctx = be->ctx_create
+        ? be->ctx_create(i_max, num_threads, old, current, next) : NULL;
+    double *ret = current;
+
+    for (int t = 0; t < t_max; ) {
+        int n = (t_max - t < every) ? t_max - t : every;
+
+        if (ctx) {
+            be->step(ctx, n);
+            ret = (double *)be->view(ctx, NULL);
+        } else {
+            double *b[3] = { bufs[0], bufs[1], bufs[2] };
+            ret = be->run(i_max, n, num_threads, b[0], b[1], b[2]);
+            for (int j = 0; j < nbufs; ++j)
+                bufs[j] = b[(n + j) % nbufs];
+        }
+        t += n;
+        if (t % every == 0)
+            wave_snap_put(snap, t, ret);
+    }
+    if (ctx)
+        be->destroy(ctx);
+    return ret;
+}
+
+int wave_driver_main(int argc, char *argv[],
+        const wave_backend_t *const backends[], int nbackends)
+{
+    double *old, *current, *next, *ret;
+    int t_max, i_max, num_threads, buffers;
+    double time;
+    double *ref_old = NULL, *ref_current = NULL, *ref_next = NULL;
+    double *init_old = NULL, *init_current = NULL, *first = NULL;
+    double *ref = NULL;
+    wave_precision_t requested, precision;
+    const double *coef;
+    int order;
+    int spectral, nref, nruns = 1;
+    int every;
+    const char *raw = getenv("WAVE_RESULT_RAW");
+    wave_arena_t arena = { 0 };
+    size_t bytes;
+    const wave_backend_t *runs[MAX_RUNS] = { backends[0] };
+    char *args[8];
+    int nargs = 0;
+
+    /* Split off the options; what remains are the positional arguments. */
+    for (int a = 0; a < argc; ++a) {
+        if (strncmp(argv[a], "--backend=", 10) == 0) {
+            if (strcmp(argv[a] + 10, "list") == 0) {
+                for (int b = 0; b < nbackends; ++b)
+                    printf("%-10s %s\n", backends[b]->name, backends[b]->desc);
+                return EXIT_SUCCESS;
+            }
+            nruns = select_backends(argv[a] + 10, backends, nbackends, runs);
+            if (nruns < 1)
+                return EXIT_FAILURE;
+        } else if (nargs < 8) {
+            args[nargs++] = argv[a];
+        }
+    }
+
+    /* Parse commandline args: i_max t_max num_threads */
+    if (nargs < 4) {
+        usage(args[0], backends, nbackends);
+        return EXIT_FAILURE;
+    }
+
+    i_max = atoi(args[1]);
+    t_max = atoi(args[2]);
+    num_threads = atoi(args[3]);
+
+    if (i_max < 3) {
+        printf("argument error: i_max should be >2.\n");
+        return EXIT_FAILURE;
+    }
+    if (t_max < 1) {
+        printf("argument error: t_max should be >=1.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads < 1) {
+        printf("argument error: num_threads should be >=1.\n");
+        return EXIT_FAILURE;
+    }
+
+    /* The reference buffers are only needed for the double reference run,
+       or the stepwise run the spectral result is checked against. */
+    requested = precision = wave_precision();
+    spectral = wave_spectral();
+    every = wave_snapshot_every();
+    if (every && spectral) {
+        fprintf(stderr, "WAVE_SNAPSHOT needs the steps in between; "
+                "WAVE_SPECTRAL ignored.\n");
+        spectral = 0;
+    }
+
+    /* Read WAVE_COEFF now, so the solvers find it cached and the file is
+       not timed. Like the solvers, a varying c rules out the fourth-order
+       stencil, and either rules out reduced precision. */
+    coef = wave_coeff(i_max);
+    order = coef ? 2 : wave_order();
+    if (coef || order == 4)
+        precision = WAVE_DOUBLE;
+    nref = (precision != WAVE_DOUBLE || spectral == 2) ? 3 : 0;
+
+    /* Allocate and initialize buffers, all from one huge-page arena.
+       WAVE_BUFFERS=2 drops the third one and lets the simulation overwrite
+       old in place. Comparing several solvers also keeps the initial data
+       and the first result. */
+    buffers = getenv("WAVE_BUFFERS") ? atoi(getenv("WAVE_BUFFERS")) : 3;
+    bytes = i_max * sizeof(double);
+    if (wave_arena_reserve(&arena, (3 + nref + (nruns > 1 ? 3 : 0))
+                           * WAVE_ARENA_CHUNK(bytes)) != 0) {
+        fprintf(stderr, "Could not map the buffer arena, aborting.\n");
+        return EXIT_FAILURE;
+    }
+    old = wave_arena_alloc(&arena, bytes, 0);
+    current = wave_arena_alloc(&arena, bytes, 0);
+    next = (buffers == 2) ? NULL : wave_arena_alloc(&arena, bytes, 0);
+
+    if (old == NULL || current == NULL || (next == NULL && buffers != 2)) {
+        fprintf(stderr, "Could not allocate enough memory, aborting.\n");
+        return EXIT_FAILURE;
+    }
+
+    clear_buffers(runs[0], i_max, num_threads, old, current, next);
+
+    /* How should we will our first two generations? */
+    if (nargs > 4) {
+        if (wave_initial_known(args[4])) {
+            wave_initial(args[4], old, current, i_max);
+        } else if (strcmp(args[4], "file") == 0) {
+            if (nargs < 7) {
+                printf("No files specified!\n");
+                return EXIT_FAILURE;
+            }
+            file_read_double_array(args[5], old, i_max);
+            file_read_double_array(args[6], current, i_max);
+        } else {
+            printf("Unknown initial mode: %s.\n", args[4]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        /* Default to sinus. */
+        wave_initial("sin", old, current, i_max);
+    }
+
+    /* Keep the initial data around for the reference run. */
+    if (nref) {
+        ref_old = wave_arena_alloc(&arena, bytes, 0);
+        ref_current = wave_arena_alloc(&arena, bytes, 0);
+        ref_next = wave_arena_alloc(&arena, bytes, 0);
+        if (ref_old == NULL || ref_current == NULL || ref_next == NULL) {
+            fprintf(stderr, "Could not allocate reference buffers, aborting.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (nruns > 1) {
+        init_old = wave_arena_alloc(&arena, bytes, 0);
+        init_current = wave_arena_alloc(&arena, bytes, 0);
+        first = wave_arena_alloc(&arena, bytes, 0);
+        if (init_old == NULL || init_current == NULL || first == NULL) {
+            fprintf(stderr, "Could not allocate comparison buffers, "
+                    "aborting.\n");
+            return EXIT_FAILURE;
+        }
+        memcpy(init_old, old, bytes);
+        memcpy(init_current, current, bytes);
+    }
+
+    for (int r = 0; r < nruns; ++r) {
+        const wave_backend_t *be = runs[r];
+        int spectral_run = spectral;
+        wave_snap_t *snap = NULL;
+
+        if (r > 0) {
+            clear_buffers(be, i_max, num_threads, old, current, next);
+            memcpy(old, init_old, bytes);
+            memcpy(current, init_current, bytes);
+        }
+        if (nref && !ref) {
+            memcpy(ref_old, old, bytes);
+            memcpy(ref_current, current, bytes);
+        }
+
+        printf("Backend: %s\n", be->name);
+
+        /* the pool is set up before the clock starts, the writer is
+           drained after it stops */
+        if (every)
+            snap = wave_snap_start(i_max);
+
+        timer_start();
+
+        /* Call the selected solver, or jump straight to t_max with
+           WAVE_SPECTRAL. */
+        ret = spectral_run ? simulate_spectral(i_max, t_max, old, current,
+                                               next)
+                           : NULL;
+        if (ret == NULL && snap) {
+            spectral_run = 0;
+            ret = run_snapshots(be, snap, every, i_max, t_max, num_threads,
+                    old, current, next);
+        } else if (ret == NULL) {
+            spectral_run = 0;
+            ret = be->run(i_max, t_max, num_threads, old, current, next);
+        }
+
+        time = timer_end();
+        wave_snap_finish(snap);
+        printf("Took %g seconds\n", time);
+        printf("Normalized: %g seconds\n", time / (1. * i_max * t_max));
+        printf("Throughput: %g Gupdates/s\n", 1e-9 * i_max * t_max / time);
+        wave_arena_report(&arena, "main");
+
+        if (nruns > 1) {
+            char name[64];
+            snprintf(name, sizeof(name), "result-%s.txt", be->name);
+            file_write_double_array(name, ret, i_max);
+        } else {
+            file_write_double_array("result.txt", ret, i_max);
+        }
+        if (raw && nruns > 1) {
+            char name[4096];
+            snprintf(name, sizeof(name), "%s-%s", raw, be->name);
+            write_raw(name, ret, i_max);
+        } else if (raw) {
+            write_raw(raw, ret, i_max);
+        }
+
+        if (spectral_run == 2) {
+            double *sref = be->run(i_max, t_max, num_threads, ref_old,
+                    ref_current, ref_next);
+            wave_report_deviation("spectral", sref, ret, i_max);
+        } else if (requested != WAVE_DOUBLE && !spectral_run
+                   && be->reduced_precision) {
+            /* the double reference is the same for every solver */
+            if (precision == WAVE_DOUBLE) {
+                printf("Precision %s: fell back to double\n",
+                       wave_precision_name(requested));
+            } else {
+                if (!ref)
+                    ref = wave_reference(i_max, t_max, order, coef, ref_old,
+                            ref_current, ref_next);
+                wave_report_deviation(wave_precision_name(precision), ref,
+                        ret, i_max);
+            }
+        }
+
+        if (nruns > 1 && r == 0) {
+            memcpy(first, ret, bytes);
+        } else if (nruns > 1) {
+            double max_abs = 0.0;
+            for (int i = 0; i < i_max; ++i) {
+                double d = fabs(ret[i] - first[i]);
+                if (d > max_abs) max_abs = d;
+            }
+            printf("Deviation from %s: max abs %g\n", runs[0]->name,
+                   max_abs);
+        }
+    }
+
+    wave_arena_release(&arena);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,21 @@
+/*
+ * driver.h
+ *
+ * Setup and output shared by the lab_1 programs: argument parsing, the
+ * initial data, buffer allocation, timing, result.txt and the reference
+ * checks. The program's main() only passes its table of solvers.
+ */
+
+#pragma once
+
+#include "backend.h"
+
+/*
+ * Usage: prog [--backend=NAME[,NAME...]] i_max t_max num_threads
+ *        [initial_data]
+ * Without --backend the first table entry runs; --backend=list prints the
+ * table. Several names run one after the other on the same initial data,
+ * each writing result-NAME.txt and its deviation from the first.
+ */
+int wave_driver_main(int argc, char *argv[],
+        const wave_backend_t *const backends[], int nbackends);
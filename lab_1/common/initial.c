@@ -0,0 +1,65 @@
+/*
+ * initial.c
+ *
+ * Built-in initial data, see initial.h.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "initial.h"
+
+typedef double (*func_t)(double x);
+
+/*
+ * Simple gauss with mu=0, sigma^1=1
+ */
+static double gauss(double x)
+{
+    return exp((-1 * x * x) / 2);
+}
+
+
+/*
+ * Fills a given array with samples of a given function. This is used to fill
+ * the initial arrays with some starting data, to run the simulation on.
+ *
+ * The first sample is placed at array index `offset'. `range' samples are
+ * taken, so your array should be able to store at least offset+range doubles.
+ * The function `f' is sampled `range' times between `sample_start' and
+ * `sample_end'.
+ */
+static void fill(double *array, int offset, int range, double sample_start,
+        double sample_end, func_t f)
+{
+    int i;
+    float dx;
+
+    dx = (sample_end - sample_start) / range;
+    for (i = 0; i < range; i++) {
+        array[i + offset] = f(sample_start + i * dx);
+    }
+}
+
+int wave_initial_known(const char *name)
+{
+    return strcmp(name, "sin") == 0 || strcmp(name, "sinfull") == 0
+        || strcmp(name, "gauss") == 0;
+}
+
+int wave_initial(const char *name, double *old, double *current, int i_max)
+{
+    if (strcmp(name, "sin") == 0) {
+        fill(old, 1, i_max/4, 0, 2*3.14, sin);
+        fill(current, 2, i_max/4, 0, 2*3.14, sin);
+    } else if (strcmp(name, "sinfull") == 0) {
+        fill(old, 1, i_max-2, 0, 10*3.14, sin);
+        fill(current, 2, i_max-3, 0, 10*3.14, sin);
+    } else if (strcmp(name, "gauss") == 0) {
+        fill(old, 1, i_max/4, -3, 3, gauss);
+        fill(current, 2, i_max/4, -3, 3, gauss);
+    } else {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * initial.h
+ *
+ * The built-in initial data of the lab_1 drivers, shared with the programs
+ * that set up runs without them (../sweep, the assign1_1 server), so every
+ * entry point starts a given mode from exactly the same arrays.
+ */
+
+#pragma once
+
+/* Non-zero if name is one of the built-in modes: sin, sinfull, gauss. */
+int wave_initial_known(const char *name);
+
+/* Fills the first two generations (zeroed arrays of i_max points) with the
+   given mode. Returns 0, or -1 for an unknown mode. */
+int wave_initial(const char *name, double *old, double *current, int i_max);
@@ -0,0 +1,34 @@
+/*
+ * partition.h
+ *
+ * Near-equal contiguous partition of the interior points [1 .. i_max-2],
+ * shared by the solvers and the first-touch initialization so that every
+ * thread touches exactly the pages it later computes on.
+ */
+
+#pragma once
+
+/* Sets [*start, *end] to the slice of thread tid out of nthreads of the
+   points [lo .. hi]. An empty slice is returned as start = lo,
+   end = lo - 1. */
+static inline void wave_partition_range(int lo, int hi, int nthreads,
+        int tid, int *start, int *end)
+{
+    int n    = (hi >= lo) ? (hi - lo + 1) : 0;
+    int base = (nthreads > 0) ? (n / nthreads) : 0;
+    int rem  = (nthreads > 0) ? (n % nthreads) : 0;
+    int len  = base + ((tid < rem) ? 1 : 0);
+    int offset = tid * base + (tid < rem ? tid : rem);
+
+    *start = (len > 0) ? (lo + offset) : lo;
+    *end   = (len > 0) ? (*start + len - 1) : lo - 1;
+}
+
+/* Sets [*start, *end] to the slice of thread tid out of nthreads. An empty
+   slice is returned as start = 1, end = 0. */
+static inline void wave_partition(int i_max, int nthreads, int tid,
+        int *start, int *end)
+{
+    wave_partition_range(1, (i_max >= 2) ? (i_max - 2) : 0, nthreads, tid,
+                         start, end);
+}
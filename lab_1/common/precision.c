@@ -0,0 +1,112 @@
+/*
+ * precision.c
+ *
+ * Float and mixed precision kernels plus the double reference used to
+ * judge them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "precision.h"
+#include "wave_kernels.h"
+
+static void kernel_float(float *restrict next, const float *restrict cur,
+        const float *restrict old, int i_begin, int i_end)
+{
+    const float c = (float)C_CONST;
+
+    for (int i = i_begin; i <= i_end; ++i) {
+        next[i] = 2.0f * cur[i] - old[i]
+                + c * (cur[i - 1] - 2.0f * cur[i] + cur[i + 1]);
+    }
+}
+
+static void kernel_mixed(float *restrict next, const float *restrict cur,
+        const float *restrict old, int i_begin, int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m = cur[i];
+        next[i] = (float)(2.0 * m - (double)old[i]
+                + C_CONST * ((double)cur[i - 1] - 2.0 * m + (double)cur[i + 1]));
+    }
+}
+
+wave_precision_t wave_precision(void)
+{
+    const char *env = getenv("WAVE_PRECISION");
+
+    if (!env || !*env || strcmp(env, "double") == 0)
+        return WAVE_DOUBLE;
+    if (strcmp(env, "float") == 0)
+        return WAVE_FLOAT;
+    if (strcmp(env, "mixed") == 0)
+        return WAVE_MIXED;
+
+    fprintf(stderr, "Unknown WAVE_PRECISION=%s; using double.\n", env);
+    return WAVE_DOUBLE;
+}
+
+const char *wave_precision_name(wave_precision_t p)
+{
+    switch (p) {
+    case WAVE_FLOAT: return "float";
+    case WAVE_MIXED: return "mixed";
+    default:         return "double";
+    }
+}
+
+wave_kernel_f_t wave_kernel_f_select(wave_precision_t p)
+{
+    return (p == WAVE_MIXED) ? kernel_mixed : kernel_float;
+}
+
+double *wave_reference(int i_max, int t_max, int order, const double *coef,
+        double *old_array, double *current_array, double *next_array)
+{
+    const int order4 = !coef && order == 4;
+
+    for (int t = 0; t < t_max; ++t) {
+        for (int i = 1; i < i_max - 1 && !order4; ++i) {
+            next_array[i] = 2.0 * current_array[i] - old_array[i]
+                          + (coef ? coef[i] : C_CONST) * (current_array[i - 1]
+                                       - 2.0 * current_array[i]
+                                       + current_array[i + 1]);
+        }
+        /* the fourth-order stencil, mirrored at the fixed ends */
+        for (int i = 1; i < i_max - 1 && order4; ++i) {
+            double m = current_array[i];
+            double l2 = (i > 1) ? current_array[i - 2] : -m;
+            double r2 = (i < i_max - 2) ? current_array[i + 2] : -m;
+            next_array[i] = 2.0 * m - old_array[i]
+                          + C4_CONST * (16.0 * (current_array[i - 1]
+                                                + current_array[i + 1])
+                                        - (l2 + r2) - 30.0 * m);
+        }
+        next_array[0] = 0.0;
+        next_array[i_max - 1] = 0.0;
+
+        double *tmp = old_array;
+        old_array = current_array;
+        current_array = next_array;
+        next_array = tmp;
+    }
+    return current_array;
+}
+
+void wave_report_deviation(const char *label, const double *ref,
+        const double *res, int n)
+{
+    double max_abs = 0.0, max_ref = 0.0;
+
+    for (int i = 0; i < n; ++i) {
+        double d = fabs(res[i] - ref[i]);
+        if (d > max_abs) max_abs = d;
+        if (fabs(ref[i]) > max_ref) max_ref = fabs(ref[i]);
+    }
+
+    printf("Precision %s: max abs deviation %g, max rel deviation %g\n",
+           label, max_abs, (max_ref > 0.0) ? max_abs / max_ref : 0.0);
+}
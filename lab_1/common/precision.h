@@ -0,0 +1,43 @@
+/*
+ * precision.h
+ *
+ * Reduced-precision storage for the lab_1 solvers. WAVE_PRECISION selects
+ *   double   plain double storage and arithmetic (default)
+ *   float    float storage and float arithmetic
+ *   mixed    float storage, every update accumulated in double
+ * The simulate() signatures stay double; the solvers convert on the way in
+ * and out, so only the time loop streams the narrower arrays.
+ */
+
+#pragma once
+
+typedef enum {
+    WAVE_DOUBLE,
+    WAVE_FLOAT,
+    WAVE_MIXED
+} wave_precision_t;
+
+typedef void (*wave_kernel_f_t)(float *restrict next,
+        const float *restrict cur, const float *restrict old,
+        int i_begin, int i_end);
+
+/* Precision requested through WAVE_PRECISION. */
+wave_precision_t wave_precision(void);
+const char *wave_precision_name(wave_precision_t p);
+
+/* Float-storage stencil kernel for WAVE_FLOAT or WAVE_MIXED. */
+wave_kernel_f_t wave_kernel_f_select(wave_precision_t p);
+
+/*
+ * Plain sequential double solver used as the reference for reduced
+ * precision runs, with the stencil order (2 or 4) and coefficients (NULL
+ * for a uniform c) the run being judged used. Overwrites the buffers like
+ * simulate() and returns the one holding generation t_max.
+ */
+double *wave_reference(int i_max, int t_max, int order, const double *coef,
+        double *old_array, double *current_array, double *next_array);
+
+/* Prints the max absolute deviation of res from ref and the same relative
+   to the largest reference amplitude. */
+void wave_report_deviation(const char *label, const double *ref,
+        const double *res, int n);
@@ -0,0 +1,72 @@
+/*
+ * reduce.c
+ *
+ * Time series of the in-situ reductions, see reduce.h.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "reduce.h"
+
+int wave_series_init(wave_series_t *s)
+{
+    const char *env = getenv("WAVE_REDUCE");
+
+    s->every = (env && atoi(env) > 0) ? atoi(env) : 0;
+    s->nrows = 0;
+    s->cap = 0;
+    s->rows = NULL;
+    return s->every > 0;
+}
+
+void wave_series_add(wave_series_t *s, int t, const wave_sums_t *sums)
+{
+    if (s->nrows == s->cap) {
+        int cap = s->cap ? 2 * s->cap : 256;
+        double *rows = realloc(s->rows, sizeof(double) * 4 * (size_t)cap);
+        if (!rows) {
+            fprintf(stderr, "Reduction buffer allocation failed; "
+                    "dropping row %d.\n", t);
+            return;
+        }
+        s->rows = rows;
+        s->cap = cap;
+    }
+
+    double *row = s->rows + 4 * (size_t)s->nrows++;
+
+    row[0] = t;
+    row[1] = 0.125 * sums->kin + 0.5 * C_CONST * sums->grad;
+    row[2] = sqrt(sums->l2);
+    row[3] = sums->amax;
+}
+
+void wave_series_finish(wave_series_t *s)
+{
+    const char *path = getenv("WAVE_REDUCE_FILE");
+    FILE *fp;
+
+    if (s->every == 0)
+        return;
+    if (!path || !*path)
+        path = "reductions.txt";
+
+    if (!(fp = fopen(path, "w"))) {
+        fprintf(stderr, "Cannot open %s for the reductions.\n", path);
+    } else {
+        for (int r = 0; r < s->nrows; ++r) {
+            const double *row = s->rows + 4 * (size_t)r;
+            fprintf(fp, "%d %.17g %.17g %.17g\n", (int)row[0], row[1],
+                    row[2], row[3]);
+        }
+        fclose(fp);
+        fprintf(stderr, "Reductions: %d rows, every %d steps, in %s\n",
+                s->nrows, s->every, path);
+    }
+
+    free(s->rows);
+    s->rows = NULL;
+    s->every = 0;
+}
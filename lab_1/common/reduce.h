@@ -0,0 +1,52 @@
+/*
+ * reduce.h
+ *
+ * In-situ reductions for the lab_1 solvers. With WAVE_REDUCE=k the solvers
+ * use the reducing kernels (wave_kernel_reduce()) on every k-th step, so
+ * the energy, L2 norm and maximum amplitude of the current generation come
+ * out of the same sweep that computes the next one. Every thread sums its
+ * own points; the partial sums are combined where the solver synchronizes
+ * anyway.
+ *
+ * The row of step t describes the generation the step reads as cur:
+ *   energy = 1/2 sum ((next - old) / 2)^2 + c/2 sum (cur[i+1] - cur[i])^2
+ * (centered velocity, in grid units; the scheme conserves it up to a small
+ * oscillation), l2 = sqrt(sum cur^2) and max = max |cur|.
+ */
+
+#pragma once
+
+#include "wave_kernels.h"
+
+typedef struct {
+    int every;      /* 0 when the reductions are off */
+    int nrows;
+    int cap;
+    double *rows;   /* t, energy, l2, max per row */
+} wave_series_t;
+
+/* Reads WAVE_REDUCE. Returns 1 if the reductions are on. */
+int wave_series_init(wave_series_t *s);
+
+/* Whether step t gets a row. */
+static inline int wave_series_due(const wave_series_t *s, int t)
+{
+    return s->every > 0 && t % s->every == 0;
+}
+
+/* Adds the partial sums b into a. */
+static inline void wave_sums_merge(wave_sums_t *a, const wave_sums_t *b)
+{
+    a->kin += b->kin;
+    a->grad += b->grad;
+    a->l2 += b->l2;
+    if (b->amax > a->amax) a->amax = b->amax;
+}
+
+/* Records the combined sums of step t (counted from the first step the
+   solver took, across calls). Rows that cannot be stored are dropped. */
+void wave_series_add(wave_series_t *s, int t, const wave_sums_t *sums);
+
+/* Writes the rows to WAVE_REDUCE_FILE (default reductions.txt) as
+   "t energy l2 max" lines and frees them. */
+void wave_series_finish(wave_series_t *s);
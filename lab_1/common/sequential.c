@@ -0,0 +1,123 @@
+/*
+ * sequential.c
+ *
+ * Single-threaded solvers for the backend table. Both track the active
+ * window (window.h) and rotate the buffers with t % n like the threaded
+ * solvers, so their results sit in the same arrays, and both take a varying
+ * c from WAVE_COEFF or the fourth-order stencil of WAVE_ORDER=4.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "backend.h"
+#include "coeff.h"
+#include "wave_kernels.h"
+#include "window.h"
+
+/*
+ * The tuned scalar reference: the stencil of wave_reference() (bit for bit
+ * the same), but with the window and with cur marked restrict, which
+ * together with the write-only next lets the compiler keep the three
+ * neighbours in registers and vectorize where it can.
+ */
+static void seq_step(double *next, const double *restrict cur,
+        const double *old, int lo, int hi)
+{
+    for (int i = lo; i <= hi; ++i) {
+        next[i] = 2.0 * cur[i] - old[i]
+                + C_CONST * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
+    }
+}
+
+/* seq_step() with coef[i] for C_CONST */
+static void seq_step_coef(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int lo, int hi)
+{
+    for (int i = lo; i <= hi; ++i) {
+        next[i] = 2.0 * cur[i] - old[i]
+                + coef[i] * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
+    }
+}
+
+/* seq_step() with the fourth-order stencil, mirrored at the fixed ends */
+static void seq_step4(double *next, const double *restrict cur,
+        const double *old, int i_max, int lo, int hi)
+{
+    for (int i = lo; i <= hi; ++i) {
+        double l2 = (i > 1) ? cur[i - 2] : -cur[1];
+        double r2 = (i < i_max - 2) ? cur[i + 2] : -cur[i_max - 2];
+        next[i] = 2.0 * cur[i] - old[i]
+                + C4_CONST * (16.0 * (cur[i - 1] + cur[i + 1]) - (l2 + r2)
+                              - 30.0 * cur[i]);
+    }
+}
+
+/* Runs t_max steps of kernel over the window, or of ckernel when c varies
+   and of kernel4 with WAVE_ORDER=4. */
+static double *run(wave_kernel_t kernel, wave_kernel_coef_t ckernel,
+        wave_kernel4_t kernel4, int i_max, int t_max, double *old_array,
+        double *current_array, double *next_array)
+{
+    const double *coef = wave_coeff(i_max);
+    const int nbufs = next_array ? 3 : 2;
+    double *bufs[3] = { old_array, current_array, next_array };
+    int order = wave_order();
+    int lo, hi;
+
+    if (coef && order == 4) {
+        fprintf(stderr, "Fourth order needs a uniform c; using second "
+                "order.\n");
+        order = 2;
+    }
+
+    wave_window(old_array, current_array, i_max, &lo, &hi);
+    wave_window_grow_by(i_max, &lo, &hi, order / 2);
+    if (next_array && (lo > 1 || hi < i_max - 2))
+        wave_window_clear(next_array, i_max, lo, hi);
+
+    for (int t = 0; t < t_max; ++t) {
+        double *old = bufs[t % nbufs];
+        double *cur = bufs[(t + 1) % nbufs];
+        double *next = bufs[(t + 2) % nbufs];
+
+        if (lo <= hi && coef)
+            ckernel(next, cur, old, coef, lo, hi);
+        else if (lo <= hi && order == 4)
+            kernel4(next, cur, old, i_max, lo, hi);
+        else if (lo <= hi)
+            kernel(next, cur, old, lo, hi);
+        next[0] = 0.0;
+        next[i_max - 1] = 0.0;
+        wave_window_grow_by(i_max, &lo, &hi, order / 2);
+    }
+    return bufs[(t_max + 1) % nbufs];
+}
+
+static double *simulate_seq(int i_max, int t_max, int num_threads,
+        double *old_array, double *current_array, double *next_array)
+{
+    (void)num_threads;
+    return run(seq_step, seq_step_coef, seq_step4, i_max, t_max, old_array,
+               current_array, next_array);
+}
+
+static double *simulate_simd(int i_max, int t_max, int num_threads,
+        double *old_array, double *current_array, double *next_array)
+{
+    /* streaming stores only pay off when next is a separate array */
+    wave_kernel_t kernel = !next_array ? wave_kernel_select()
+        : wave_kernel_for(3 * sizeof(double) * (size_t)i_max);
+
+    (void)num_threads;
+    return run(kernel, wave_kernel_coef(), wave_kernel4(), i_max, t_max,
+               old_array, current_array, next_array);
+}
+
+const wave_backend_t wave_backend_seq = {
+    "seq", "sequential scalar reference", simulate_seq, NULL, 0
+};
+
+const wave_backend_t wave_backend_simd = {
+    "simd", "sequential, vector kernel", simulate_simd, NULL, 0
+};
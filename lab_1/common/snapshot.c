@@ -0,0 +1,214 @@
+/*
+ * snapshot.c
+ *
+ * Asynchronous snapshot writer, see snapshot.h.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snapshot.h"
+
+#define DEFAULT_BUFS 4
+
+struct wave_snap {
+    int i_max;
+    int nbufs;
+    double *data;          /* nbufs copies of a generation */
+    int *step;             /* generation held by each buffer */
+
+    /* buffers waiting for the writer, oldest first, and the free ones */
+    int *queue, head, queued;
+    int *spare, nspare;
+    int done;
+
+    pthread_mutex_t lock;
+    pthread_cond_t ready;  /* a buffer was queued, or done was set */
+    pthread_cond_t freed;  /* the writer gave a buffer back */
+    pthread_t writer;
+
+    /* counters; the writer's are only read after the join */
+    long written;
+    long long bytes;
+    double busy;
+    long stalls;
+    double stalled;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int wave_snapshot_every(void)
+{
+    const char *env = getenv("WAVE_SNAPSHOT");
+    return (env && atoi(env) > 0) ? atoi(env) : 0;
+}
+
+/* Writes one buffer in the format of result.txt. Returns the bytes
+   written, or -1. */
+static long long write_snapshot(int t, const double *gen, int i_max)
+{
+    char name[32];
+    long long bytes = 0;
+    FILE *fp;
+
+    snprintf(name, sizeof(name), "snapshot-%d.txt", t);
+    if (!(fp = fopen(name, "w"))) {
+        fprintf(stderr, "Cannot open %s; snapshot dropped.\n", name);
+        return -1;
+    }
+    for (int i = 0; i < i_max; ++i)
+        bytes += fprintf(fp, "%f\n", gen[i]);
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "Writing %s failed.\n", name);
+        return -1;
+    }
+    return bytes;
+}
+
+static void *writer_main(void *arg)
+{
+    wave_snap_t *s = arg;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->queued && !s->done)
+            pthread_cond_wait(&s->ready, &s->lock);
+        if (!s->queued)
+            break;
+
+        int b = s->queue[s->head];
+        s->head = (s->head + 1) % s->nbufs;
+        --s->queued;
+
+        /* format and write outside the lock; the buffer is ours until it
+           goes back to the spares */
+        pthread_mutex_unlock(&s->lock);
+        double t0 = now();
+        long long bytes = write_snapshot(s->step[b],
+                s->data + (size_t)b * s->i_max, s->i_max);
+        s->busy += now() - t0;
+        if (bytes >= 0) {
+            ++s->written;
+            s->bytes += bytes;
+        }
+        pthread_mutex_lock(&s->lock);
+
+        s->spare[s->nspare++] = b;
+        pthread_cond_signal(&s->freed);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+wave_snap_t *wave_snap_start(int i_max)
+{
+    const char *env = getenv("WAVE_SNAPSHOT_BUFS");
+    int nbufs = (env && atoi(env) > 0) ? atoi(env) : DEFAULT_BUFS;
+    wave_snap_t *s = calloc(1, sizeof(wave_snap_t));
+
+    if (nbufs < 2)
+        nbufs = 2;
+    if (s) {
+        s->data = malloc(sizeof(double) * (size_t)i_max * nbufs);
+        s->step = malloc(sizeof(int) * nbufs);
+        s->queue = malloc(sizeof(int) * nbufs);
+        s->spare = malloc(sizeof(int) * nbufs);
+    }
+    if (!s || !s->data || !s->step || !s->queue || !s->spare) {
+        fprintf(stderr, "Snapshot buffer allocation failed; snapshots "
+                "off.\n");
+        goto fail;
+    }
+
+    s->i_max = i_max;
+    s->nbufs = nbufs;
+    for (int b = 0; b < nbufs; ++b)
+        s->spare[b] = b;
+    s->nspare = nbufs;
+
+    /* touch the pool now rather than on the first snapshots */
+    memset(s->data, 0, sizeof(double) * (size_t)i_max * nbufs);
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->ready, NULL);
+    pthread_cond_init(&s->freed, NULL);
+    if (pthread_create(&s->writer, NULL, writer_main, s) != 0) {
+        fprintf(stderr, "Cannot start the snapshot writer; snapshots "
+                "off.\n");
+        pthread_cond_destroy(&s->freed);
+        pthread_cond_destroy(&s->ready);
+        pthread_mutex_destroy(&s->lock);
+        goto fail;
+    }
+    return s;
+
+fail:
+    if (s) {
+        free(s->data);
+        free(s->step);
+        free(s->queue);
+        free(s->spare);
+        free(s);
+    }
+    return NULL;
+}
+
+void wave_snap_put(wave_snap_t *s, int t, const double *gen)
+{
+    pthread_mutex_lock(&s->lock);
+    if (!s->nspare) {
+        double t0 = now();
+        while (!s->nspare)
+            pthread_cond_wait(&s->freed, &s->lock);
+        s->stalled += now() - t0;
+        ++s->stalls;
+    }
+    int b = s->spare[--s->nspare];
+    pthread_mutex_unlock(&s->lock);
+
+    /* the buffer is off both lists, so the copy needs no lock */
+    memcpy(s->data + (size_t)b * s->i_max, gen, sizeof(double) * s->i_max);
+    s->step[b] = t;
+
+    pthread_mutex_lock(&s->lock);
+    s->queue[(s->head + s->queued) % s->nbufs] = b;
+    ++s->queued;
+    pthread_cond_signal(&s->ready);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void wave_snap_finish(wave_snap_t *s)
+{
+    if (!s)
+        return;
+
+    double t0 = now();
+    pthread_mutex_lock(&s->lock);
+    s->done = 1;
+    pthread_cond_signal(&s->ready);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->writer, NULL);
+    double drain = now() - t0;
+
+    fprintf(stderr, "Snapshots: %ld written, %lld bytes, writer busy %g s; "
+            "%ld stalls, %g s stalled, %g s draining at the end (%d "
+            "buffers).\n", s->written, s->bytes, s->busy, s->stalls,
+            s->stalled, drain, s->nbufs);
+
+    pthread_cond_destroy(&s->freed);
+    pthread_cond_destroy(&s->ready);
+    pthread_mutex_destroy(&s->lock);
+    free(s->data);
+    free(s->step);
+    free(s->queue);
+    free(s->spare);
+    free(s);
+}
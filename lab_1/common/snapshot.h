@@ -0,0 +1,34 @@
+/*
+ * snapshot.h
+ *
+ * Intermediate results for the lab_1 drivers. WAVE_SNAPSHOT=k saves the
+ * wave every k steps as snapshot-<t>.txt, in the format of result.txt,
+ * without stopping the simulation for the text output: the generation is
+ * copied into one of a pool of preallocated buffers and queued for a
+ * writer thread, which formats and writes it while the solver runs on.
+ * The solver only waits when every buffer of the pool is still queued.
+ * WAVE_SNAPSHOT_BUFS=n sets the pool size (default 4, at least 2).
+ *
+ * wave_snap_finish() prints what the writer did: snapshots and bytes
+ * written, its busy time, and how long and how often the solver stalled
+ * on a full pool.
+ */
+
+#pragma once
+
+typedef struct wave_snap wave_snap_t;
+
+/* Steps between snapshots from WAVE_SNAPSHOT, or 0 when they are off. */
+int wave_snapshot_every(void);
+
+/* Allocates the pool for waves of i_max points and starts the writer.
+   Returns NULL (after a message) when either fails. */
+wave_snap_t *wave_snap_start(int i_max);
+
+/* Queues a copy of generation t. Returns once gen has been copied, so the
+   caller may overwrite it right away. */
+void wave_snap_put(wave_snap_t *s, int t, const double *gen);
+
+/* Waits for the queued snapshots to be written, stops the writer, prints
+   the counters and frees the pool. */
+void wave_snap_finish(wave_snap_t *s);
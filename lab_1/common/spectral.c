@@ -0,0 +1,247 @@
+/*
+ * spectral.c
+ *
+ * DST-I based fast-forward solver, see spectral.h. The DST of the N
+ * interior points is taken from the FFT of their odd extension to length
+ * 2(N+1), computed as a complex FFT of length N+1 (the real-input trick);
+ * lengths that are not a power of two go through Bluestein's algorithm.
+ */
+
+#include <complex.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coeff.h"
+#include "spectral.h"
+#include "wave_kernels.h"
+
+#define PI 3.14159265358979323846
+
+typedef double complex cplx;
+
+/* Everything needed for repeated transforms of one length. */
+typedef struct {
+    size_t m;       /* complex DFT length, N + 1 */
+    size_t M;       /* power-of-two FFT length (m, or >= 2m - 1) */
+    cplx *tw;       /* e^(-2 pi i j / M) for j < M / 2 */
+    cplx *chirp;    /* Bluestein chirp e^(-pi i n^2 / m); NULL if m == M */
+    cplx *bhat;     /* FFT of the conjugate chirp */
+    cplx *work;     /* M entries */
+    cplx *z;        /* m entries */
+} dst_plan_t;
+
+/* In-place iterative radix-2 FFT of length p->M; unnormalized inverse. */
+static void fft(const dst_plan_t *p, cplx *a, int inverse)
+{
+    const size_t n = p->M;
+
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            cplx t = a[i];
+            a[i] = a[j];
+            a[j] = t;
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const size_t half = len / 2, step = n / len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; ++j) {
+                cplx w = inverse ? conj(p->tw[j * step]) : p->tw[j * step];
+                cplx u = a[i + j];
+                cplx v = a[i + j + half] * w;
+                a[i + j] = u + v;
+                a[i + j + half] = u - v;
+            }
+        }
+    }
+}
+
+/* Forward DFT of length p->m of p->z, in place. */
+static void dft(const dst_plan_t *p)
+{
+    const size_t m = p->m, M = p->M;
+
+    if (!p->chirp) {
+        fft(p, p->z, 0);
+        return;
+    }
+
+    for (size_t n = 0; n < m; ++n)
+        p->work[n] = p->z[n] * p->chirp[n];
+    memset(p->work + m, 0, sizeof(cplx) * (M - m));
+    fft(p, p->work, 0);
+    for (size_t n = 0; n < M; ++n)
+        p->work[n] *= p->bhat[n];
+    fft(p, p->work, 1);
+    for (size_t k = 0; k < m; ++k)
+        p->z[k] = p->chirp[k] * p->work[k] / (double)M;
+}
+
+static void plan_destroy(dst_plan_t *p)
+{
+    free(p->tw);
+    free(p->chirp);
+    free(p->bhat);
+    free(p->work);
+    free(p->z);
+}
+
+static int plan_init(dst_plan_t *p, size_t m)
+{
+    size_t M = 1;
+
+    while (M < m) M <<= 1;
+    if (M != m) {
+        M = 1;
+        while (M < 2 * m - 1) M <<= 1;
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->m = m;
+    p->M = M;
+    p->tw = malloc(sizeof(cplx) * (M / 2 + 1));
+    p->z = malloc(sizeof(cplx) * m);
+    if (M != m) {
+        p->chirp = malloc(sizeof(cplx) * m);
+        p->bhat = malloc(sizeof(cplx) * M);
+        p->work = malloc(sizeof(cplx) * M);
+    }
+    if (!p->tw || !p->z || (M != m && (!p->chirp || !p->bhat || !p->work))) {
+        plan_destroy(p);
+        return -1;
+    }
+
+    for (size_t j = 0; j < M / 2; ++j) {
+        double a = -2.0 * PI * (double)j / (double)M;
+        p->tw[j] = cos(a) + I * sin(a);
+    }
+
+    if (M != m) {
+        /* n^2 mod 2m keeps the chirp phase exact for large n */
+        for (size_t n = 0; n < m; ++n) {
+            unsigned long long q = (unsigned long long)n * n % (2 * m);
+            double a = -PI * (double)q / (double)m;
+            p->chirp[n] = cos(a) + I * sin(a);
+        }
+        memset(p->bhat, 0, sizeof(cplx) * M);
+        p->bhat[0] = conj(p->chirp[0]);
+        for (size_t n = 1; n < m; ++n)
+            p->bhat[n] = p->bhat[M - n] = conj(p->chirp[n]);
+        fft(p, p->bhat, 0);
+    }
+    return 0;
+}
+
+/*
+ * X[k-1] = sum_j x[j-1] sin(pi j k / m) for j, k = 1 .. m-1 (DST-I). The
+ * odd extension y of x has length 2m; its FFT is Y = -2i X.
+ */
+static void dst1(const dst_plan_t *p, const double *x, double *X)
+{
+    const size_t m = p->m, L = 2 * m;
+
+    for (size_t n = 0; n < m; ++n) {
+        size_t j0 = 2 * n, j1 = 2 * n + 1;
+        double y0 = (j0 == 0 || j0 == m) ? 0.0
+                  : (j0 < m) ? x[j0 - 1] : -x[L - j0 - 1];
+        double y1 = (j1 == m) ? 0.0
+                  : (j1 < m) ? x[j1 - 1] : -x[L - j1 - 1];
+        p->z[n] = y0 + I * y1;
+    }
+
+    dft(p);
+
+    for (size_t k = 1; k < m; ++k) {
+        cplx zk = p->z[k], zc = conj(p->z[m - k]);
+        cplx even = 0.5 * (zk + zc);
+        cplx odd = -0.5 * I * (zk - zc);
+        double a = -PI * (double)k / (double)m;
+        cplx y = even + (cos(a) + I * sin(a)) * odd;
+        X[k - 1] = -0.5 * cimag(y);
+    }
+}
+
+double *simulate_spectral(const int i_max, const int t_max,
+        double *old_array, double *current_array, double *next_array)
+{
+    if (t_max <= 0 || i_max < 3) return current_array;
+
+    /* the sine modes only diagonalize a uniform c */
+    if (wave_coeff(i_max)) {
+        fprintf(stderr, "Spectral solver: c varies; stepping instead.\n");
+        return NULL;
+    }
+
+    const int N = i_max - 2;
+    const int nbufs = next_array ? 3 : 2;
+    double *bufs[3] = { old_array, current_array, next_array };
+    double *res_old = bufs[t_max % nbufs];
+    double *res_cur = bufs[(t_max + 1) % nbufs];
+    dst_plan_t p;
+
+    double *a0 = malloc(sizeof(double) * N);
+    double *a1 = malloc(sizeof(double) * N);
+    if (!a0 || !a1 || plan_init(&p, (size_t)N + 1) != 0) {
+        fprintf(stderr, "Spectral solver: out of memory.\n");
+        free(a0);
+        free(a1);
+        return NULL;
+    }
+
+    dst1(&p, old_array + 1, a0);
+    dst1(&p, current_array + 1, a1);
+
+    /* mode k: cos(theta) = 1 - 2 c sin^2(pi k / 2m), i.e.
+       sin(theta / 2) = sqrt(c) sin(pi k / 2m), which keeps theta accurate
+       for the slow modes where acos would not. The fourth-order stencil,
+       odd-mirrored at the ends like the sines, has the eigenvalue
+       -4 s^2 (1 + s^2 / 3) for s = sin(pi k / 2m). */
+    const double n_cur = (double)t_max + 1.0, n_old = (double)t_max;
+    const int order4 = (wave_order() == 4);
+    for (int k = 0; k < N; ++k) {
+        double s = sin(PI * (k + 1) / (2.0 * (N + 1)));
+        if (order4)
+            s *= sqrt(1.0 + s * s / 3.0);
+        double th = 2.0 * asin(sqrt(C_CONST) * s);
+        double b = (a1[k] - a0[k] * cos(th)) / sin(th);
+
+        a1[k] = a0[k] * cos(n_cur * th) + b * sin(n_cur * th);
+        a0[k] = a0[k] * cos(n_old * th) + b * sin(n_old * th);
+    }
+
+    /* DST-I is its own inverse up to a factor 2 / m */
+    const double scale = 2.0 / (N + 1);
+    dst1(&p, a1, res_cur + 1);
+    for (int i = 1; i <= N; ++i) res_cur[i] *= scale;
+    res_cur[0] = res_cur[i_max - 1] = 0.0;
+
+    /* after a single step the older generation is the untouched input */
+    if (t_max >= 2) {
+        dst1(&p, a0, res_old + 1);
+        for (int i = 1; i <= N; ++i) res_old[i] *= scale;
+        res_old[0] = res_old[i_max - 1] = 0.0;
+    }
+
+    plan_destroy(&p);
+    free(a0);
+    free(a1);
+    return res_cur;
+}
+
+int wave_spectral(void)
+{
+    const char *env = getenv("WAVE_SPECTRAL");
+
+    if (!env || !*env || strcmp(env, "off") == 0 || strcmp(env, "0") == 0)
+        return 0;
+    if (strcmp(env, "check") == 0)
+        return 2;
+    return 1;
+}
@@ -0,0 +1,33 @@
+/*
+ * spectral.h
+ *
+ * Spectral fast-forward for the lab_1 solvers. With zero ends the scheme is
+ * diagonalized by the discrete sine transform (DST-I) of the interior:
+ * every sine mode k obeys a_{n+1} = 2 cos(theta_k) a_n - a_{n-1} on its
+ * own, which has the closed form
+ *   a_n = a_0 cos(n theta) + (a_1 - a_0 cos(theta)) sin(n theta) / sin(theta).
+ * Transforming, advancing every mode to t_max and transforming back costs
+ * O(i_max log i_max) whatever t_max is. The result equals the stepwise one
+ * up to rounding, which accumulates differently. The fourth-order stencil
+ * (WAVE_ORDER=4) has the same modes, with other frequencies.
+ */
+
+#pragma once
+
+/*
+ * Same contract as simulate(): the initial generations are in old_array and
+ * current_array, and the final two are left where the stepwise solvers
+ * leave them (bufs[(t_max + 1) % n] and bufs[t_max % n], with n = 2 when
+ * next_array is NULL). Returns the array holding the final generation like
+ * simulate() does, or NULL when the transform buffers cannot be allocated
+ * or c varies (WAVE_COEFF, see coeff.h).
+ *
+ * The transforms are fastest when i_max - 1 is a power of two; other sizes
+ * go through Bluestein's algorithm and need about twice the memory.
+ */
+double *simulate_spectral(const int i_max, const int t_max,
+        double *old_array, double *current_array, double *next_array);
+
+/* Spectral mode requested through WAVE_SPECTRAL: 0 = off, 1 = on,
+   2 = on and also run the stepwise solver to report the deviation. */
+int wave_spectral(void);
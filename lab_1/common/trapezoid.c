@@ -0,0 +1,49 @@
+/*
+ * trapezoid.c
+ *
+ * Serial cache-oblivious trapezoid walk, see trapezoid.h.
+ */
+
+#include "trapezoid.h"
+
+/* Computes the rows of a trapezoid one step at a time. */
+static void sweep(const wave_trap_t *w, int t0, int t1, int x0, int dx0,
+        int x1, int dx1)
+{
+    const int n = w->nbufs;
+
+    for (int t = t0; t < t1; ++t) {
+        int xa = x0 + dx0 * (t - t0);
+        int xb = x1 + dx1 * (t - t0);
+        double *next = w->bufs[(t + 2) % n];
+
+        if (xa >= xb) continue;
+        w->kernel(next, w->bufs[(t + 1) % n], w->bufs[t % n], xa, xb - 1);
+        if (xa == 1) next[0] = 0.0;
+        if (xb == w->i_max - 1) next[w->i_max - 1] = 0.0;
+    }
+}
+
+void wave_trapezoid(const wave_trap_t *w, int t0, int t1, int x0, int dx0,
+        int x1, int dx1)
+{
+    const int dt = t1 - t0;
+    const int top = (x1 + dx1 * dt) - (x0 + dx0 * dt);
+    const int wide = (top > x1 - x0) ? top : x1 - x0;
+
+    if (dt <= 0) return;
+    if (dt == 1 || wide <= TRAP_BASE) {
+        sweep(w, t0, t1, x0, dx0, x1, dx1);
+    } else if (2L * (x1 - x0) + (long)(dx1 - dx0) * dt >= 4L * dt) {
+        /* space cut through the middle with slope -1: the left piece does
+           not depend on the right one */
+        int xm = (int)((2L * x0 + 2L * x1 + (long)(2 + dx0 + dx1) * dt) / 4);
+        wave_trapezoid(w, t0, t1, x0, dx0, xm, -1);
+        wave_trapezoid(w, t0, t1, xm, -1, x1, dx1);
+    } else {
+        /* time cut: lower half first */
+        int s = dt / 2;
+        wave_trapezoid(w, t0, t0 + s, x0, dx0, x1, dx1);
+        wave_trapezoid(w, t0 + s, t1, x0 + dx0 * s, dx0, x1 + dx1 * s, dx1);
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ * trapezoid.h
+ *
+ * Cache-oblivious space-time traversal (Frigo and Strumpen) for the lab_1
+ * solvers. A trapezoid covers steps [t0, t1) and at step t the points
+ * [x0 + dx0 * (t - t0), x1 + dx1 * (t - t0)), with slopes dx0, dx1 in
+ * {-1, 0, 1}. Cutting it recursively in space and time yields pieces whose
+ * data fits in some level of cache whatever its size, so a point is loaded
+ * from memory about once per cache-sized block of steps instead of once per
+ * step.
+ *
+ * Step t reads bufs[t % nbufs] (old) and bufs[(t + 1) % nbufs] (cur) and
+ * writes bufs[(t + 2) % nbufs], as the barrier solvers do. Every value a
+ * point overwrites has only been read by points it depends on, so the time
+ * buffers can be reused in any order that respects the dependencies.
+ */
+
+#pragma once
+
+#include "wave_kernels.h"
+
+typedef struct {
+    double *bufs[3];
+    int nbufs;       /* 3, or 2 when next overwrites old in place */
+    int i_max;
+    wave_kernel_t kernel;
+} wave_trap_t;
+
+/* Trapezoids at most this many points wide (48 KiB over the three time
+   levels, well within any L2) are swept step by step; cutting them further
+   only adds recursion and kernel call overhead. */
+#define TRAP_BASE 2048
+
+/* Executes a trapezoid serially in dependency order. */
+void wave_trapezoid(const wave_trap_t *w, int t0, int t1, int x0, int dx0,
+        int x1, int dx1);
@@ -0,0 +1,37 @@
+/*
+ * wave_ctx.h
+ *
+ * Incremental stepping API of the lab_1 solvers, implemented by both
+ * simulate.c files. A context is set up once (mode selection, partitions,
+ * barriers, scratch buffers and, for the pthreads solver, parked worker
+ * threads) and can then be advanced any number of steps at a time; the
+ * buffer rotation stays inside. simulate() is create + one wave_step() +
+ * destroy.
+ */
+
+#pragma once
+
+typedef struct wave_ctx wave_ctx_t;
+
+/*
+ * Sets up a solver for waves of i_max points on num_threads threads. The
+ * arrays are borrowed, not copied: old_array and current_array hold the
+ * two initial generations, next_array is the third buffer, or NULL to
+ * update old_array in place. Returns NULL when the context cannot be
+ * allocated.
+ */
+wave_ctx_t *wave_ctx_create(int i_max, int num_threads, double *old_array,
+        double *current_array, double *next_array);
+
+/* Advances n steps. Returns 0, or -1 when the context is NULL. */
+int wave_step(wave_ctx_t *ctx, int n);
+
+/*
+ * Returns the current generation without copying; if prev is not NULL it
+ * receives the one before. Both point into the borrowed arrays and stay
+ * valid until the next wave_step().
+ */
+const double *wave_view(const wave_ctx_t *ctx, const double **prev);
+
+/* Stops the threads and frees the context; the arrays stay the caller's. */
+void wave_destroy(wave_ctx_t *ctx);
@@ -0,0 +1,1051 @@
+/*
+ * wave_kernels.c
+ *
+ * Hand-vectorized stencil kernels with runtime ISA dispatch. The vector
+ * kernels are compiled with per-function target attributes, so one binary
+ * runs everywhere and only uses the instructions the host has.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "wave_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WAVE_X86 1
+#endif
+
+static void kernel_scalar(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        next[i] = 2.0 * cur[i] - old[i]
+                + C_CONST * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
+    }
+}
+
+/*
+ * Batch kernels: `width' strings interleaved with the given stride, so
+ * point i of string c is at i * stride + c. Each computes
+ * next[i * stride + c] for i in [i_begin, i_end] and c < width, vectorizing
+ * across the strings. Rounding follows the 1D kernels: the scalar and SSE2
+ * versions match the plain loop bit for bit, the AVX ones fuse the
+ * multiply-add of every string, partial vectors included, and match the
+ * AVX 1D kernels bit for bit.
+ */
+static void batch_scalar(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, int width, long stride)
+{
+    for (long i = i_begin; i <= i_end; ++i) {
+        const double *m = cur + i * stride;
+        for (int c = 0; c < width; ++c) {
+            next[i * stride + c] = 2.0 * m[c] - old[i * stride + c]
+                    + C_CONST * (m[c - stride] - 2.0 * m[c] + m[c + stride]);
+        }
+    }
+}
+
+/*
+ * Reducing kernels: the plain kernel plus the reduction terms of every
+ * point, from values already in registers. old[i] is loaded before next[i]
+ * is stored, so they work in place too.
+ */
+static void reduce_scalar(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, wave_sums_t *acc)
+{
+    double kin = 0.0, grad = 0.0, l2 = 0.0, amax = acc->amax;
+
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m = cur[i], o = old[i];
+        double v = 2.0 * m - o + C_CONST * (cur[i - 1] - 2.0 * m + cur[i + 1]);
+        double d = v - o, g = cur[i + 1] - m, a = fabs(m);
+
+        next[i] = v;
+        kin += d * d;
+        grad += g * g;
+        l2 += m * m;
+        if (a > amax) amax = a;
+    }
+    acc->kin += kin;
+    acc->grad += grad;
+    acc->l2 += l2;
+    acc->amax = amax;
+}
+
+/*
+ * Variable-coefficient kernels: C_CONST replaced by coef[i], which costs one
+ * more read stream. The vector versions load coef at the same offsets as
+ * the other arrays, so an aligned coef array keeps those loads aligned
+ * wherever next is.
+ */
+static void coef_scalar(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int i_begin,
+        int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        next[i] = 2.0 * cur[i] - old[i]
+                + coef[i] * (cur[i - 1] - 2.0 * cur[i] + cur[i + 1]);
+    }
+}
+
+/*
+ * 2D row kernels: the up and down neighbours are the same column one pitch
+ * before and after. The vector versions load them at the same offsets as
+ * the row itself, so with rows aligned to the vector width so are they.
+ */
+static void row2d_scalar(double *next, const double *restrict cur,
+        const double *old, long pitch, int j_begin, int j_end)
+{
+    const double *up = cur - pitch, *down = cur + pitch;
+
+    for (int j = j_begin; j <= j_end; ++j) {
+        next[j] = 2.0 * cur[j] - old[j]
+                + C_CONST * ((cur[j - 1] + cur[j + 1]) + (up[j] + down[j])
+                             - 4.0 * cur[j]);
+    }
+}
+
+/*
+ * Fourth-order kernels. o4_point() is the reference for one point, with
+ * the odd mirror at the fixed ends; o4_edges() computes the points next to
+ * the ends with it and leaves the range where all five neighbours are in
+ * the array to the unrolled loops.
+ */
+static inline double o4_point(const double *restrict cur, const double *old,
+        int i_max, int i)
+{
+    double l2 = (i > 1) ? cur[i - 2] : -cur[1];
+    double r2 = (i < i_max - 2) ? cur[i + 2] : -cur[i_max - 2];
+    double m = cur[i];
+
+    return 2.0 * m - old[i]
+         + C4_CONST * (16.0 * (cur[i - 1] + cur[i + 1]) - (l2 + r2)
+                       - 30.0 * m);
+}
+
+static inline void o4_edges(double *next, const double *restrict cur,
+        const double *old, int i_max, int *i_begin, int *i_end)
+{
+    for (; *i_begin <= *i_end && *i_begin < 2; ++*i_begin)
+        next[*i_begin] = o4_point(cur, old, i_max, *i_begin);
+    for (; *i_end >= *i_begin && *i_end > i_max - 3; --*i_end)
+        next[*i_end] = o4_point(cur, old, i_max, *i_end);
+}
+
+static void o4_inner(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m = cur[i];
+        next[i] = 2.0 * m - old[i]
+                + C4_CONST * (16.0 * (cur[i - 1] + cur[i + 1])
+                              - (cur[i - 2] + cur[i + 2]) - 30.0 * m);
+    }
+}
+
+static void o4_scalar(double *next, const double *restrict cur,
+        const double *old, int i_max, int i_begin, int i_end)
+{
+    o4_edges(next, cur, old, i_max, &i_begin, &i_end);
+    o4_inner(next, cur, old, i_begin, i_end);
+}
+
+#ifdef WAVE_X86
+
+/*
+ * Fused scalar loops for the tails of the AVX kernels. They do the
+ * operations of the vector bodies in the same order and round the final
+ * multiply-add once with fma(), so a point comes out with the same bits
+ * whether the vector body or the tail computes it, and the result does not
+ * depend on where the threads split the range.
+ */
+__attribute__((target("fma")))
+static void kernel_fused(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m2 = 2.0 * cur[i];
+        next[i] = fma(C_CONST, (cur[i - 1] - m2) + cur[i + 1], m2 - old[i]);
+    }
+}
+
+__attribute__((target("fma")))
+static void reduce_fused(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, wave_sums_t *acc)
+{
+    double kin = 0.0, grad = 0.0, l2 = 0.0, amax = acc->amax;
+
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m = cur[i], o = old[i], m2 = 2.0 * m;
+        double v = fma(C_CONST, (cur[i - 1] - m2) + cur[i + 1], m2 - o);
+        double d = v - o, g = cur[i + 1] - m, a = fabs(m);
+
+        next[i] = v;
+        kin += d * d;
+        grad += g * g;
+        l2 += m * m;
+        if (a > amax) amax = a;
+    }
+    acc->kin += kin;
+    acc->grad += grad;
+    acc->l2 += l2;
+    acc->amax = amax;
+}
+
+__attribute__((target("fma")))
+static void coef_fused(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int i_begin,
+        int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m2 = 2.0 * cur[i];
+        next[i] = fma(coef[i], (cur[i - 1] - m2) + cur[i + 1], m2 - old[i]);
+    }
+}
+
+__attribute__((target("fma")))
+static void row2d_fused(double *next, const double *restrict cur,
+        const double *old, long pitch, int j_begin, int j_end)
+{
+    const double *up = cur - pitch, *down = cur + pitch;
+
+    for (int j = j_begin; j <= j_end; ++j) {
+        double lap = ((cur[j - 1] + cur[j + 1]) + (up[j] + down[j]))
+                   - 4.0 * cur[j];
+        next[j] = fma(C_CONST, lap, 2.0 * cur[j] - old[j]);
+    }
+}
+
+/* o4_inner() fused; the edge points always go through o4_point() */
+__attribute__((target("fma")))
+static void o4_fused(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    for (int i = i_begin; i <= i_end; ++i) {
+        double m = cur[i];
+        double lap = (16.0 * (cur[i - 1] + cur[i + 1])
+                      - (cur[i - 2] + cur[i + 2])) - 30.0 * m;
+        next[i] = fma(C4_CONST, lap, 2.0 * m - old[i]);
+    }
+}
+
+__attribute__((target("sse2")))
+static void kernel_sse2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d c = _mm_set1_pd(C_CONST);
+    int i = i_begin;
+
+    for (; i + 1 <= i_end; i += 2) {
+        __m128d l = _mm_loadu_pd(cur + i - 1);
+        __m128d m = _mm_loadu_pd(cur + i);
+        __m128d r = _mm_loadu_pd(cur + i + 1);
+        __m128d o = _mm_loadu_pd(old + i);
+        __m128d m2 = _mm_mul_pd(two, m);
+        __m128d lap = _mm_add_pd(_mm_sub_pd(l, m2), r);
+        __m128d v = _mm_add_pd(_mm_sub_pd(m2, o), _mm_mul_pd(c, lap));
+        _mm_storeu_pd(next + i, v);
+    }
+    kernel_scalar(next, cur, old, i, i_end);
+}
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d c = _mm256_set1_pd(C_CONST);
+    int i = i_begin;
+
+    for (; i + 3 <= i_end; i += 4) {
+        __m256d l = _mm256_loadu_pd(cur + i - 1);
+        __m256d m = _mm256_loadu_pd(cur + i);
+        __m256d r = _mm256_loadu_pd(cur + i + 1);
+        __m256d o = _mm256_loadu_pd(old + i);
+        __m256d m2 = _mm256_mul_pd(two, m);
+        __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+        __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+        _mm256_storeu_pd(next + i, v);
+    }
+    kernel_fused(next, cur, old, i, i_end);
+}
+
+__attribute__((target("avx512f")))
+static void kernel_avx512(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d c = _mm512_set1_pd(C_CONST);
+    int i = i_begin;
+
+    for (; i + 7 <= i_end; i += 8) {
+        __m512d l = _mm512_loadu_pd(cur + i - 1);
+        __m512d m = _mm512_loadu_pd(cur + i);
+        __m512d r = _mm512_loadu_pd(cur + i + 1);
+        __m512d o = _mm512_loadu_pd(old + i);
+        __m512d m2 = _mm512_mul_pd(two, m);
+        __m512d lap = _mm512_add_pd(_mm512_sub_pd(l, m2), r);
+        __m512d v = _mm512_fmadd_pd(c, lap, _mm512_sub_pd(m2, o));
+        _mm512_storeu_pd(next + i, v);
+    }
+    kernel_fused(next, cur, old, i, i_end);
+}
+
+/*
+ * Streaming-store variants. Writing next[] through the cache costs a read
+ * for ownership of every line on top of the write itself; non-temporal
+ * stores skip it, so each point moves 24 instead of 32 bytes once the arrays
+ * no longer fit in the last-level cache. Stores need aligned addresses, so
+ * the head is peeled off with the scalar tail loop of the same ISA, which
+ * rounds like the vector body, and the final sfence makes the weakly
+ * ordered stores visible before the caller's barrier. next[] comes out
+ * exactly as from the cached kernel.
+ */
+
+/* first index >= i where next + index is aligned to `align' bytes */
+static inline int aligned_from(const double *next, int i, int i_end,
+        uintptr_t align)
+{
+    while (i <= i_end && ((uintptr_t)(next + i) & (align - 1)) != 0)
+        ++i;
+    return i;
+}
+
+__attribute__((target("sse2")))
+static void kernel_sse2_nt(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d c = _mm_set1_pd(C_CONST);
+    int i = aligned_from(next, i_begin, i_end, 16);
+
+    kernel_scalar(next, cur, old, i_begin, i - 1);
+    for (; i + 1 <= i_end; i += 2) {
+        __m128d l = _mm_loadu_pd(cur + i - 1);
+        __m128d m = _mm_loadu_pd(cur + i);
+        __m128d r = _mm_loadu_pd(cur + i + 1);
+        __m128d o = _mm_loadu_pd(old + i);
+        __m128d m2 = _mm_mul_pd(two, m);
+        __m128d lap = _mm_add_pd(_mm_sub_pd(l, m2), r);
+        __m128d v = _mm_add_pd(_mm_sub_pd(m2, o), _mm_mul_pd(c, lap));
+        _mm_stream_pd(next + i, v);
+    }
+    kernel_scalar(next, cur, old, i, i_end);
+    _mm_sfence();
+}
+
+__attribute__((target("avx2,fma")))
+static void kernel_avx2_nt(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d c = _mm256_set1_pd(C_CONST);
+    int i = aligned_from(next, i_begin, i_end, 32);
+
+    kernel_fused(next, cur, old, i_begin, i - 1);
+    for (; i + 3 <= i_end; i += 4) {
+        __m256d l = _mm256_loadu_pd(cur + i - 1);
+        __m256d m = _mm256_loadu_pd(cur + i);
+        __m256d r = _mm256_loadu_pd(cur + i + 1);
+        __m256d o = _mm256_loadu_pd(old + i);
+        __m256d m2 = _mm256_mul_pd(two, m);
+        __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+        __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+        _mm256_stream_pd(next + i, v);
+    }
+    kernel_fused(next, cur, old, i, i_end);
+    _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+static void kernel_avx512_nt(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d c = _mm512_set1_pd(C_CONST);
+    int i = aligned_from(next, i_begin, i_end, 64);
+
+    kernel_fused(next, cur, old, i_begin, i - 1);
+    for (; i + 7 <= i_end; i += 8) {
+        __m512d l = _mm512_loadu_pd(cur + i - 1);
+        __m512d m = _mm512_loadu_pd(cur + i);
+        __m512d r = _mm512_loadu_pd(cur + i + 1);
+        __m512d o = _mm512_loadu_pd(old + i);
+        __m512d m2 = _mm512_mul_pd(two, m);
+        __m512d lap = _mm512_add_pd(_mm512_sub_pd(l, m2), r);
+        __m512d v = _mm512_fmadd_pd(c, lap, _mm512_sub_pd(m2, o));
+        _mm512_stream_pd(next + i, v);
+    }
+    kernel_fused(next, cur, old, i, i_end);
+    _mm_sfence();
+}
+
+__attribute__((target("sse2")))
+static void batch_sse2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, int width, long stride)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d c = _mm_set1_pd(C_CONST);
+    const int vw = width & ~1;
+
+    for (long i = i_begin; i <= i_end; ++i) {
+        const double *row = cur + i * stride;
+        for (int k = 0; k < vw; k += 2) {
+            __m128d l = _mm_loadu_pd(row + k - stride);
+            __m128d m = _mm_loadu_pd(row + k);
+            __m128d r = _mm_loadu_pd(row + k + stride);
+            __m128d o = _mm_loadu_pd(old + i * stride + k);
+            __m128d m2 = _mm_mul_pd(two, m);
+            __m128d lap = _mm_add_pd(_mm_sub_pd(l, m2), r);
+            __m128d v = _mm_add_pd(_mm_sub_pd(m2, o), _mm_mul_pd(c, lap));
+            _mm_storeu_pd(next + i * stride + k, v);
+        }
+        if (vw < width) {
+            batch_scalar(next + vw, cur + vw, old + vw, (int)i, (int)i,
+                         width - vw, stride);
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void batch_avx2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, int width, long stride)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d c = _mm256_set1_pd(C_CONST);
+    const int vw = width & ~3;
+
+    for (long i = i_begin; i <= i_end; ++i) {
+        const double *row = cur + i * stride;
+        for (int k = 0; k < vw; k += 4) {
+            __m256d l = _mm256_loadu_pd(row + k - stride);
+            __m256d m = _mm256_loadu_pd(row + k);
+            __m256d r = _mm256_loadu_pd(row + k + stride);
+            __m256d o = _mm256_loadu_pd(old + i * stride + k);
+            __m256d m2 = _mm256_mul_pd(two, m);
+            __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+            __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+            _mm256_storeu_pd(next + i * stride + k, v);
+        }
+        if (vw < width) {
+            /* a masked remainder, fused like the full vectors */
+            const __m256i msk = _mm256_cmpgt_epi64(
+                    _mm256_set1_epi64x(width - vw),
+                    _mm256_set_epi64x(3, 2, 1, 0));
+            __m256d l = _mm256_maskload_pd(row + vw - stride, msk);
+            __m256d m = _mm256_maskload_pd(row + vw, msk);
+            __m256d r = _mm256_maskload_pd(row + vw + stride, msk);
+            __m256d o = _mm256_maskload_pd(old + i * stride + vw, msk);
+            __m256d m2 = _mm256_mul_pd(two, m);
+            __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+            __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+            _mm256_maskstore_pd(next + i * stride + vw, msk, v);
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+static void batch_avx512(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, int width, long stride)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d c = _mm512_set1_pd(C_CONST);
+
+    for (long i = i_begin; i <= i_end; ++i) {
+        const double *row = cur + i * stride;
+        for (int k = 0; k < width; k += 8) {
+            /* a masked tail keeps partial blocks vectorized */
+            const __mmask8 msk = (width - k >= 8) ? 0xff
+                               : (__mmask8)((1u << (width - k)) - 1);
+            __m512d l = _mm512_maskz_loadu_pd(msk, row + k - stride);
+            __m512d m = _mm512_maskz_loadu_pd(msk, row + k);
+            __m512d r = _mm512_maskz_loadu_pd(msk, row + k + stride);
+            __m512d o = _mm512_maskz_loadu_pd(msk, old + i * stride + k);
+            __m512d m2 = _mm512_mul_pd(two, m);
+            __m512d lap = _mm512_add_pd(_mm512_sub_pd(l, m2), r);
+            __m512d v = _mm512_fmadd_pd(c, lap, _mm512_sub_pd(m2, o));
+            _mm512_mask_storeu_pd(next + i * stride + k, msk, v);
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void reduce_sse2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, wave_sums_t *acc)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d c = _mm_set1_pd(C_CONST);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d kin = _mm_setzero_pd(), grad = _mm_setzero_pd();
+    __m128d l2 = _mm_setzero_pd(), amax = _mm_setzero_pd();
+    double k[2], g[2], q[2], a[2];
+    int i = i_begin;
+
+    for (; i + 1 <= i_end; i += 2) {
+        __m128d l = _mm_loadu_pd(cur + i - 1);
+        __m128d m = _mm_loadu_pd(cur + i);
+        __m128d r = _mm_loadu_pd(cur + i + 1);
+        __m128d o = _mm_loadu_pd(old + i);
+        __m128d m2 = _mm_mul_pd(two, m);
+        __m128d lap = _mm_add_pd(_mm_sub_pd(l, m2), r);
+        __m128d v = _mm_add_pd(_mm_sub_pd(m2, o), _mm_mul_pd(c, lap));
+        __m128d d = _mm_sub_pd(v, o), dg = _mm_sub_pd(r, m);
+        _mm_storeu_pd(next + i, v);
+        kin = _mm_add_pd(kin, _mm_mul_pd(d, d));
+        grad = _mm_add_pd(grad, _mm_mul_pd(dg, dg));
+        l2 = _mm_add_pd(l2, _mm_mul_pd(m, m));
+        amax = _mm_max_pd(amax, _mm_andnot_pd(sign, m));
+    }
+    _mm_storeu_pd(k, kin);
+    _mm_storeu_pd(g, grad);
+    _mm_storeu_pd(q, l2);
+    _mm_storeu_pd(a, amax);
+    acc->kin += k[0] + k[1];
+    acc->grad += g[0] + g[1];
+    acc->l2 += q[0] + q[1];
+    acc->amax = fmax(acc->amax, fmax(a[0], a[1]));
+    reduce_scalar(next, cur, old, i, i_end, acc);
+}
+
+__attribute__((target("avx2,fma")))
+static void reduce_avx2(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, wave_sums_t *acc)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d c = _mm256_set1_pd(C_CONST);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d kin = _mm256_setzero_pd(), grad = _mm256_setzero_pd();
+    __m256d l2 = _mm256_setzero_pd(), amax = _mm256_setzero_pd();
+    double k[4], g[4], q[4], a[4];
+    int i = i_begin;
+
+    for (; i + 3 <= i_end; i += 4) {
+        __m256d l = _mm256_loadu_pd(cur + i - 1);
+        __m256d m = _mm256_loadu_pd(cur + i);
+        __m256d r = _mm256_loadu_pd(cur + i + 1);
+        __m256d o = _mm256_loadu_pd(old + i);
+        __m256d m2 = _mm256_mul_pd(two, m);
+        __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+        __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+        __m256d d = _mm256_sub_pd(v, o), dg = _mm256_sub_pd(r, m);
+        _mm256_storeu_pd(next + i, v);
+        kin = _mm256_fmadd_pd(d, d, kin);
+        grad = _mm256_fmadd_pd(dg, dg, grad);
+        l2 = _mm256_fmadd_pd(m, m, l2);
+        amax = _mm256_max_pd(amax, _mm256_andnot_pd(sign, m));
+    }
+    _mm256_storeu_pd(k, kin);
+    _mm256_storeu_pd(g, grad);
+    _mm256_storeu_pd(q, l2);
+    _mm256_storeu_pd(a, amax);
+    acc->kin += (k[0] + k[1]) + (k[2] + k[3]);
+    acc->grad += (g[0] + g[1]) + (g[2] + g[3]);
+    acc->l2 += (q[0] + q[1]) + (q[2] + q[3]);
+    acc->amax = fmax(acc->amax, fmax(fmax(a[0], a[1]), fmax(a[2], a[3])));
+    reduce_fused(next, cur, old, i, i_end, acc);
+}
+
+__attribute__((target("avx512f")))
+static void reduce_avx512(double *next, const double *restrict cur,
+        const double *old, int i_begin, int i_end, wave_sums_t *acc)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d c = _mm512_set1_pd(C_CONST);
+    __m512d kin = _mm512_setzero_pd(), grad = _mm512_setzero_pd();
+    __m512d l2 = _mm512_setzero_pd(), amax = _mm512_setzero_pd();
+    int i = i_begin;
+
+    for (; i + 7 <= i_end; i += 8) {
+        __m512d l = _mm512_loadu_pd(cur + i - 1);
+        __m512d m = _mm512_loadu_pd(cur + i);
+        __m512d r = _mm512_loadu_pd(cur + i + 1);
+        __m512d o = _mm512_loadu_pd(old + i);
+        __m512d m2 = _mm512_mul_pd(two, m);
+        __m512d lap = _mm512_add_pd(_mm512_sub_pd(l, m2), r);
+        __m512d v = _mm512_fmadd_pd(c, lap, _mm512_sub_pd(m2, o));
+        __m512d d = _mm512_sub_pd(v, o), dg = _mm512_sub_pd(r, m);
+        _mm512_storeu_pd(next + i, v);
+        kin = _mm512_fmadd_pd(d, d, kin);
+        grad = _mm512_fmadd_pd(dg, dg, grad);
+        l2 = _mm512_fmadd_pd(m, m, l2);
+        amax = _mm512_max_pd(amax, _mm512_abs_pd(m));
+    }
+    acc->kin += _mm512_reduce_add_pd(kin);
+    acc->grad += _mm512_reduce_add_pd(grad);
+    acc->l2 += _mm512_reduce_add_pd(l2);
+    acc->amax = fmax(acc->amax, _mm512_reduce_max_pd(amax));
+    reduce_fused(next, cur, old, i, i_end, acc);
+}
+
+__attribute__((target("sse2")))
+static void coef_sse2(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int i_begin,
+        int i_end)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    int i = i_begin;
+
+    for (; i + 1 <= i_end; i += 2) {
+        __m128d l = _mm_loadu_pd(cur + i - 1);
+        __m128d m = _mm_loadu_pd(cur + i);
+        __m128d r = _mm_loadu_pd(cur + i + 1);
+        __m128d o = _mm_loadu_pd(old + i);
+        __m128d c = _mm_loadu_pd(coef + i);
+        __m128d m2 = _mm_mul_pd(two, m);
+        __m128d lap = _mm_add_pd(_mm_sub_pd(l, m2), r);
+        __m128d v = _mm_add_pd(_mm_sub_pd(m2, o), _mm_mul_pd(c, lap));
+        _mm_storeu_pd(next + i, v);
+    }
+    coef_scalar(next, cur, old, coef, i, i_end);
+}
+
+__attribute__((target("avx2,fma")))
+static void coef_avx2(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int i_begin,
+        int i_end)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    int i = i_begin;
+
+    for (; i + 3 <= i_end; i += 4) {
+        __m256d l = _mm256_loadu_pd(cur + i - 1);
+        __m256d m = _mm256_loadu_pd(cur + i);
+        __m256d r = _mm256_loadu_pd(cur + i + 1);
+        __m256d o = _mm256_loadu_pd(old + i);
+        __m256d c = _mm256_loadu_pd(coef + i);
+        __m256d m2 = _mm256_mul_pd(two, m);
+        __m256d lap = _mm256_add_pd(_mm256_sub_pd(l, m2), r);
+        __m256d v = _mm256_fmadd_pd(c, lap, _mm256_sub_pd(m2, o));
+        _mm256_storeu_pd(next + i, v);
+    }
+    coef_fused(next, cur, old, coef, i, i_end);
+}
+
+__attribute__((target("avx512f")))
+static void coef_avx512(double *next, const double *restrict cur,
+        const double *old, const double *restrict coef, int i_begin,
+        int i_end)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    int i = i_begin;
+
+    for (; i + 7 <= i_end; i += 8) {
+        __m512d l = _mm512_loadu_pd(cur + i - 1);
+        __m512d m = _mm512_loadu_pd(cur + i);
+        __m512d r = _mm512_loadu_pd(cur + i + 1);
+        __m512d o = _mm512_loadu_pd(old + i);
+        __m512d c = _mm512_loadu_pd(coef + i);
+        __m512d m2 = _mm512_mul_pd(two, m);
+        __m512d lap = _mm512_add_pd(_mm512_sub_pd(l, m2), r);
+        __m512d v = _mm512_fmadd_pd(c, lap, _mm512_sub_pd(m2, o));
+        _mm512_storeu_pd(next + i, v);
+    }
+    coef_fused(next, cur, old, coef, i, i_end);
+}
+
+__attribute__((target("sse2")))
+static void row2d_sse2(double *next, const double *restrict cur,
+        const double *old, long pitch, int j_begin, int j_end)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d four = _mm_set1_pd(4.0);
+    const __m128d c = _mm_set1_pd(C_CONST);
+    int j = j_begin;
+
+    for (; j + 1 <= j_end; j += 2) {
+        __m128d l = _mm_loadu_pd(cur + j - 1);
+        __m128d m = _mm_loadu_pd(cur + j);
+        __m128d r = _mm_loadu_pd(cur + j + 1);
+        __m128d u = _mm_loadu_pd(cur + j - pitch);
+        __m128d d = _mm_loadu_pd(cur + j + pitch);
+        __m128d o = _mm_loadu_pd(old + j);
+        __m128d lap = _mm_sub_pd(_mm_add_pd(_mm_add_pd(l, r),
+                                            _mm_add_pd(u, d)),
+                                 _mm_mul_pd(four, m));
+        __m128d v = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(two, m), o),
+                               _mm_mul_pd(c, lap));
+        _mm_storeu_pd(next + j, v);
+    }
+    row2d_scalar(next, cur, old, pitch, j, j_end);
+}
+
+__attribute__((target("avx2,fma")))
+static void row2d_avx2(double *next, const double *restrict cur,
+        const double *old, long pitch, int j_begin, int j_end)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d c = _mm256_set1_pd(C_CONST);
+    int j = j_begin;
+
+    for (; j + 3 <= j_end; j += 4) {
+        __m256d l = _mm256_loadu_pd(cur + j - 1);
+        __m256d m = _mm256_loadu_pd(cur + j);
+        __m256d r = _mm256_loadu_pd(cur + j + 1);
+        __m256d u = _mm256_loadu_pd(cur + j - pitch);
+        __m256d d = _mm256_loadu_pd(cur + j + pitch);
+        __m256d o = _mm256_loadu_pd(old + j);
+        __m256d lap = _mm256_sub_pd(_mm256_add_pd(_mm256_add_pd(l, r),
+                                                  _mm256_add_pd(u, d)),
+                                    _mm256_mul_pd(four, m));
+        __m256d v = _mm256_fmadd_pd(c, lap,
+                _mm256_sub_pd(_mm256_mul_pd(two, m), o));
+        _mm256_storeu_pd(next + j, v);
+    }
+    row2d_fused(next, cur, old, pitch, j, j_end);
+}
+
+__attribute__((target("avx512f")))
+static void row2d_avx512(double *next, const double *restrict cur,
+        const double *old, long pitch, int j_begin, int j_end)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d c = _mm512_set1_pd(C_CONST);
+    int j = j_begin;
+
+    for (; j + 7 <= j_end; j += 8) {
+        __m512d l = _mm512_loadu_pd(cur + j - 1);
+        __m512d m = _mm512_loadu_pd(cur + j);
+        __m512d r = _mm512_loadu_pd(cur + j + 1);
+        __m512d u = _mm512_loadu_pd(cur + j - pitch);
+        __m512d d = _mm512_loadu_pd(cur + j + pitch);
+        __m512d o = _mm512_loadu_pd(old + j);
+        __m512d lap = _mm512_sub_pd(_mm512_add_pd(_mm512_add_pd(l, r),
+                                                  _mm512_add_pd(u, d)),
+                                    _mm512_mul_pd(four, m));
+        __m512d v = _mm512_fmadd_pd(c, lap,
+                _mm512_sub_pd(_mm512_mul_pd(two, m), o));
+        _mm512_storeu_pd(next + j, v);
+    }
+    row2d_fused(next, cur, old, pitch, j, j_end);
+}
+
+/*
+ * Register-blocked fourth-order kernels. Each step loads the vectors
+ * starting at i-2 and i+2 (AVX-512) or carries the previous load over
+ * (SSE2, AVX2), and builds the shifted neighbour vectors from those with
+ * shuffles.
+ */
+__attribute__((target("sse2")))
+static void o4_sse2(double *next, const double *restrict cur,
+        const double *old, int i_max, int i_begin, int i_end)
+{
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d w1 = _mm_set1_pd(16.0);
+    const __m128d w0 = _mm_set1_pd(30.0);
+    const __m128d c = _mm_set1_pd(C4_CONST);
+
+    o4_edges(next, cur, old, i_max, &i_begin, &i_end);
+    int i = i_begin;
+    if (i + 1 > i_end) {
+        o4_inner(next, cur, old, i, i_end);
+        return;
+    }
+
+    /* a = cur[i-2 .. i-1], b = cur[i .. i+1], d = cur[i+2 .. i+3] */
+    __m128d a = _mm_loadu_pd(cur + i - 2);
+    __m128d b = _mm_loadu_pd(cur + i);
+    for (; i + 1 <= i_end; i += 2) {
+        __m128d d = _mm_loadu_pd(cur + i + 2);
+        __m128d l1 = _mm_shuffle_pd(a, b, 1);
+        __m128d r1 = _mm_shuffle_pd(b, d, 1);
+        __m128d o = _mm_loadu_pd(old + i);
+        __m128d lap = _mm_sub_pd(_mm_sub_pd(
+                _mm_mul_pd(w1, _mm_add_pd(l1, r1)), _mm_add_pd(a, d)),
+                _mm_mul_pd(w0, b));
+        __m128d v = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(two, b), o),
+                               _mm_mul_pd(c, lap));
+        _mm_storeu_pd(next + i, v);
+        a = b;
+        b = d;
+    }
+    o4_inner(next, cur, old, i, i_end);
+}
+
+__attribute__((target("avx2,fma")))
+static void o4_avx2(double *next, const double *restrict cur,
+        const double *old, int i_max, int i_begin, int i_end)
+{
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d w1 = _mm256_set1_pd(16.0);
+    const __m256d w0 = _mm256_set1_pd(30.0);
+    const __m256d c = _mm256_set1_pd(C4_CONST);
+
+    o4_edges(next, cur, old, i_max, &i_begin, &i_end);
+    int i = i_begin;
+    if (i + 3 > i_end) {
+        o4_fused(next, cur, old, i, i_end);
+        return;
+    }
+
+    /* a = cur[i-2 .. i+1], b = cur[i+2 .. i+5]; b is the next a */
+    __m256d a = _mm256_loadu_pd(cur + i - 2);
+    for (; i + 3 <= i_end; i += 4) {
+        __m256d b = _mm256_loadu_pd(cur + i + 2);
+        __m256d m = _mm256_permute2f128_pd(a, b, 0x21);
+        __m256d l1 = _mm256_shuffle_pd(a, m, 0x5);
+        __m256d r1 = _mm256_shuffle_pd(m, b, 0x5);
+        __m256d o = _mm256_loadu_pd(old + i);
+        __m256d lap = _mm256_sub_pd(_mm256_sub_pd(
+                _mm256_mul_pd(w1, _mm256_add_pd(l1, r1)),
+                _mm256_add_pd(a, b)), _mm256_mul_pd(w0, m));
+        __m256d v = _mm256_fmadd_pd(c, lap,
+                _mm256_sub_pd(_mm256_mul_pd(two, m), o));
+        _mm256_storeu_pd(next + i, v);
+        a = b;
+    }
+    o4_fused(next, cur, old, i, i_end);
+}
+
+__attribute__((target("avx512f")))
+static void o4_avx512(double *next, const double *restrict cur,
+        const double *old, int i_max, int i_begin, int i_end)
+{
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d w1 = _mm512_set1_pd(16.0);
+    const __m512d w0 = _mm512_set1_pd(30.0);
+    const __m512d c = _mm512_set1_pd(C4_CONST);
+    /* lanes of (a, b) holding cur[i-1..], cur[i..] and cur[i+1..] */
+    const __m512i il = _mm512_set_epi64(12, 7, 6, 5, 4, 3, 2, 1);
+    const __m512i im = _mm512_set_epi64(13, 12, 7, 6, 5, 4, 3, 2);
+    const __m512i ir = _mm512_set_epi64(14, 13, 12, 7, 6, 5, 4, 3);
+
+    o4_edges(next, cur, old, i_max, &i_begin, &i_end);
+    int i = i_begin;
+
+    /* a = cur[i-2 .. i+5], b = cur[i+2 .. i+9] */
+    for (; i + 7 <= i_end; i += 8) {
+        __m512d a = _mm512_loadu_pd(cur + i - 2);
+        __m512d b = _mm512_loadu_pd(cur + i + 2);
+        __m512d l1 = _mm512_permutex2var_pd(a, il, b);
+        __m512d m = _mm512_permutex2var_pd(a, im, b);
+        __m512d r1 = _mm512_permutex2var_pd(a, ir, b);
+        __m512d o = _mm512_loadu_pd(old + i);
+        __m512d lap = _mm512_sub_pd(_mm512_sub_pd(
+                _mm512_mul_pd(w1, _mm512_add_pd(l1, r1)),
+                _mm512_add_pd(a, b)), _mm512_mul_pd(w0, m));
+        __m512d v = _mm512_fmadd_pd(c, lap,
+                _mm512_sub_pd(_mm512_mul_pd(two, m), o));
+        _mm512_storeu_pd(next + i, v);
+    }
+    o4_fused(next, cur, old, i, i_end);
+}
+
+#endif /* WAVE_X86 */
+
+static const struct {
+    const char *name;
+    wave_kernel_t fn;
+    wave_kernel_t nt;   /* streaming-store variant, if any */
+    wave_kernel_batch_t batch;
+    wave_kernel_reduce_t reduce;
+    wave_kernel_coef_t coef;
+    wave_kernel4_t o4;
+    wave_kernel_2d_t row2d;
+} kernels[] = {
+    { "scalar", kernel_scalar, NULL,             batch_scalar, reduce_scalar,
+      coef_scalar, o4_scalar, row2d_scalar },
+#ifdef WAVE_X86
+    { "sse2",   kernel_sse2,   kernel_sse2_nt,   batch_sse2,   reduce_sse2,
+      coef_sse2,   o4_sse2,   row2d_sse2 },
+    { "avx2",   kernel_avx2,   kernel_avx2_nt,   batch_avx2,   reduce_avx2,
+      coef_avx2,   o4_avx2,   row2d_avx2 },
+    { "avx512", kernel_avx512, kernel_avx512_nt, batch_avx512, reduce_avx512,
+      coef_avx512, o4_avx512, row2d_avx512 },
+#endif
+};
+
+static int selected = -1;
+
+static int cpu_has(const char *name)
+{
+#ifdef WAVE_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0)
+        return __builtin_cpu_supports("sse2");
+    if (strcmp(name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (strcmp(name, "avx512") == 0)
+        return __builtin_cpu_supports("avx512f");
+#endif
+    return strcmp(name, "scalar") == 0;
+}
+
+wave_kernel_t wave_kernel_select(void)
+{
+    const int n = (int)(sizeof(kernels) / sizeof(kernels[0]));
+
+    if (selected >= 0)
+        return kernels[selected].fn;
+
+    const char *env = getenv("WAVE_KERNEL");
+    if (env && *env) {
+        for (int k = 0; k < n; ++k) {
+            if (strcmp(env, kernels[k].name) == 0) {
+                if (cpu_has(env))
+                    selected = k;
+                else
+                    fprintf(stderr, "Kernel %s not supported by this CPU.\n",
+                            env);
+                break;
+            }
+        }
+        if (selected < 0)
+            fprintf(stderr, "Ignoring WAVE_KERNEL=%s.\n", env);
+    }
+
+    /* otherwise take the widest one the CPU supports */
+    for (int k = n - 1; selected < 0 && k >= 0; --k) {
+        if (cpu_has(kernels[k].name))
+            selected = k;
+    }
+
+    fprintf(stderr, "Stencil kernel: %s\n", kernels[selected].name);
+    return kernels[selected].fn;
+}
+
+wave_kernel_batch_t wave_kernel_batch(void)
+{
+    wave_kernel_select();
+    return kernels[selected].batch;
+}
+
+wave_kernel_reduce_t wave_kernel_reduce(void)
+{
+    wave_kernel_select();
+    return kernels[selected].reduce;
+}
+
+wave_kernel_coef_t wave_kernel_coef(void)
+{
+    wave_kernel_select();
+    return kernels[selected].coef;
+}
+
+wave_kernel4_t wave_kernel4(void)
+{
+    wave_kernel_select();
+    return kernels[selected].o4;
+}
+
+wave_kernel_2d_t wave_kernel_2d(void)
+{
+    wave_kernel_select();
+    return kernels[selected].row2d;
+}
+
+int wave_order(void)
+{
+    static int order;
+
+    if (!order) {
+        const char *env = getenv("WAVE_ORDER");
+        order = (env && atoi(env) == 4) ? 4 : 2;
+        if (env && *env && atoi(env) != 2 && atoi(env) != 4)
+            fprintf(stderr, "Ignoring WAVE_ORDER=%s.\n", env);
+        if (order == 4)
+            fprintf(stderr, "Stencil order: 4\n");
+    }
+    return order;
+}
+
+const char *wave_kernel_name(void)
+{
+    wave_kernel_select();
+    return kernels[selected].name;
+}
+
+/* Parses a size such as "32M", "2048K" or "1073741824". */
+static size_t parse_size(const char *s)
+{
+    char *end;
+    double v = strtod(s, &end);
+
+    switch (*end) {
+    case 'G': case 'g': v *= 1024.0;  /* fall through */
+    case 'M': case 'm': v *= 1024.0;  /* fall through */
+    case 'K': case 'k': v *= 1024.0;  break;
+    default: break;
+    }
+    return (v > 0.0) ? (size_t)v : 0;
+}
+
+size_t wave_cache_size(void)
+{
+    static size_t cached;
+    const char *env = getenv("WAVE_CACHE_SIZE");
+    int best_level = 0;
+
+    if (env && *env)
+        return parse_size(env);
+    if (cached)
+        return cached;
+
+    /* the largest data/unified cache level of CPU 0 */
+    for (int idx = 0; idx < 16; ++idx) {
+        char path[96], type[32] = "", size[32] = "";
+        int level = 0;
+        FILE *fp;
+
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+        if (!(fp = fopen(path, "r")))
+            break;
+        if (fscanf(fp, "%d", &level) != 1) level = 0;
+        fclose(fp);
+
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+        if ((fp = fopen(path, "r"))) {
+            if (fscanf(fp, "%31s", type) != 1) type[0] = '\0';
+            fclose(fp);
+        }
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        if ((fp = fopen(path, "r"))) {
+            if (fscanf(fp, "%31s", size) != 1) size[0] = '\0';
+            fclose(fp);
+        }
+
+        if (strcmp(type, "Instruction") != 0 && level > best_level) {
+            best_level = level;
+            cached = parse_size(size);
+        }
+    }
+
+    if (!cached)
+        cached = (size_t)32 << 20;
+    return cached;
+}
+
+wave_kernel_t wave_kernel_for(size_t working_set)
+{
+    static int reported;
+    wave_kernel_t fn = wave_kernel_select();
+    wave_kernel_t nt = kernels[selected].nt;
+    const char *env = getenv("WAVE_NT");
+    int use;
+
+    if (env && strcmp(env, "on") == 0)
+        use = 1;
+    else if (env && strcmp(env, "off") == 0)
+        use = 0;
+    else
+        use = working_set > wave_cache_size();
+    if (!nt)
+        use = 0;
+
+    if (!reported) {
+        fprintf(stderr, "Streaming stores: %s (working set %zu KiB, "
+                "cache %zu KiB)\n", use ? "on" : "off", working_set >> 10,
+                wave_cache_size() >> 10);
+        reported = 1;
+    }
+    return use ? nt : fn;
+}
@@ -0,0 +1,126 @@
+/*
+ * wave_kernels.h
+ *
+ * Stencil kernels shared by the pthreads and OpenMP wave solvers. Each
+ * kernel computes next[i] for i in [i_begin, i_end] from cur and old.
+ * next may be the same array as old: old[i] is only read to compute
+ * next[i], and always before it is written.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#define C_CONST 0.15  /* spatial impact constant c */
+#define C4_CONST (C_CONST / 12.0)  /* c / 12, of the fourth-order stencil */
+
+typedef void (*wave_kernel_t)(double *next,
+        const double *restrict cur, const double *old,
+        int i_begin, int i_end);
+
+/*
+ * Returns the fastest kernel this CPU supports (checked with CPUID once and
+ * reported on stderr). WAVE_KERNEL=scalar|sse2|avx2|avx512 forces a kernel.
+ * The scalar and SSE2 kernels reproduce the plain C loop bit for bit. The
+ * AVX2 and AVX-512 kernels fuse the final multiply-add, which rounds once
+ * instead of twice, so their results differ from the plain loop's in the
+ * last bits. They fuse it in their scalar tails too: every point is
+ * computed the same way wherever a range starts or ends, so for a given
+ * kernel the result does not depend on the thread count or the solver.
+ */
+wave_kernel_t wave_kernel_select(void);
+
+/*
+ * Kernel for interleaved batches: point i of string c sits at
+ * i * stride + c, and next is computed for rows i_begin .. i_end of
+ * strings 0 .. width-1, vectorized across the strings.
+ */
+typedef void (*wave_kernel_batch_t)(double *next,
+        const double *restrict cur, const double *old,
+        int i_begin, int i_end, int width, long stride);
+
+/* Batch counterpart of wave_kernel_select(), for the same ISA. */
+wave_kernel_batch_t wave_kernel_batch(void);
+
+/* Partial sums of the in-situ reductions (see reduce.h). */
+typedef struct {
+    double kin;    /* sum of (next[i] - old[i])^2 */
+    double grad;   /* sum of (cur[i + 1] - cur[i])^2 */
+    double l2;     /* sum of cur[i]^2 */
+    double amax;   /* max of |cur[i]| */
+} wave_sums_t;
+
+/*
+ * Kernel that also accumulates the reductions of the points it computes
+ * into *acc, in the same sweep. next[] comes out exactly as from the plain
+ * kernel of the same ISA.
+ */
+typedef void (*wave_kernel_reduce_t)(double *next,
+        const double *restrict cur, const double *old,
+        int i_begin, int i_end, wave_sums_t *acc);
+
+/* Reducing counterpart of wave_kernel_select(), for the same ISA. */
+wave_kernel_reduce_t wave_kernel_reduce(void);
+
+/*
+ * Kernel for a spatially varying c: coef[i] takes the place of C_CONST at
+ * point i. With coef[i] == C_CONST everywhere next[] comes out exactly as
+ * from the plain kernel of the same ISA. See coeff.h for where coef comes
+ * from.
+ */
+typedef void (*wave_kernel_coef_t)(double *next,
+        const double *restrict cur, const double *old,
+        const double *restrict coef, int i_begin, int i_end);
+
+/* Variable-coefficient counterpart of wave_kernel_select(). */
+wave_kernel_coef_t wave_kernel_coef(void);
+
+/*
+ * Fourth-order kernels (WAVE_ORDER=4): the 5-point Laplacian
+ *   (-u[i-2] + 16 u[i-1] - 30 u[i] + 16 u[i+1] - u[i+2]) / 12
+ * in place of the 3-point one, for the same c. i_max locates the fixed
+ * ends: the points next to them see the wave continued as an odd mirror
+ * (u[-1] = -u[1]), which is what keeps a fixed end fourth-order accurate.
+ * Reads cur[i_begin-2 .. i_end+2] otherwise. The vector versions load each
+ * vector of cur once or twice and shift the neighbours out of registers,
+ * so the two extra neighbours cost shuffles rather than loads; the memory
+ * traffic stays that of the 3-point kernels. Rounding follows them too.
+ */
+typedef void (*wave_kernel4_t)(double *next,
+        const double *restrict cur, const double *old,
+        int i_max, int i_begin, int i_end);
+
+/* Fourth-order counterpart of wave_kernel_select(). */
+wave_kernel4_t wave_kernel4(void);
+
+/*
+ * Row kernel of the 2D solver (../wave2d): next, cur and old point to the
+ * start of one row of a grid whose rows are pitch doubles apart, and
+ * next[j] is computed for j in [j_begin, j_end] from the 5-point stencil
+ *   cur[j-1] + cur[j+1] + cur[j-pitch] + cur[j+pitch] - 4 cur[j].
+ * Rounding follows the 1D kernels.
+ */
+typedef void (*wave_kernel_2d_t)(double *next,
+        const double *restrict cur, const double *old, long pitch,
+        int j_begin, int j_end);
+
+/* 2D counterpart of wave_kernel_select(), for the same ISA. */
+wave_kernel_2d_t wave_kernel_2d(void);
+
+/* Spatial order set with WAVE_ORDER: 2 (the default) or 4. */
+int wave_order(void);
+
+/* Name of the kernel returned by wave_kernel_select(). */
+const char *wave_kernel_name(void);
+
+/* Size in bytes of the last-level cache, read from sysfs once.
+   WAVE_CACHE_SIZE (e.g. "32M") overrides it. */
+size_t wave_cache_size(void);
+
+/*
+ * Like wave_kernel_select(), but returns the streaming-store variant of the
+ * kernel when the arrays swept every step (working_set bytes) exceed
+ * wave_cache_size(). WAVE_NT=on|off forces the choice; the scalar kernel
+ * has no streaming variant.
+ */
+wave_kernel_t wave_kernel_for(size_t working_set);
@@ -0,0 +1,59 @@
+/*
+ * window.h
+ *
+ * Active-window tracking. Outside the points where old or cur is nonzero
+ * the next generation is exactly zero (2 * 0 - 0 + c * 0), and the nonzero
+ * part grows by at most one point per step on each side (two with the
+ * fourth-order stencil). Initial data that
+ * fills only part of the wave (sin, gauss) therefore needs only its window,
+ * widened every step, to be computed until it covers the interior.
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Sets [*lo, *hi] to the smallest part of the interior [1 .. i_max-2]
+   holding every nonzero point of old and cur; lo > hi if there are none.
+   WAVE_WINDOW=off returns the whole interior. */
+static inline void wave_window(const double *old, const double *cur,
+        int i_max, int *lo, int *hi)
+{
+    const char *env = getenv("WAVE_WINDOW");
+    int a = 1, b = i_max - 2;
+
+    if (!(env && strcmp(env, "off") == 0)) {
+        while (a <= b && old[a] == 0.0 && cur[a] == 0.0) ++a;
+        while (b >= a && old[b] == 0.0 && cur[b] == 0.0) --b;
+    }
+    *lo = a;
+    *hi = b;
+}
+
+/* Widens the window by the reach points per side a step can reach. */
+static inline void wave_window_grow_by(int i_max, int *lo, int *hi,
+        int reach)
+{
+    if (*lo > *hi) return;
+    *lo = (*lo - reach > 1) ? *lo - reach : 1;
+    *hi = (*hi + reach < i_max - 2) ? *hi + reach : i_max - 2;
+}
+
+/* Widens the window by the one point per side a 3-point step can reach. */
+static inline void wave_window_grow(int i_max, int *lo, int *hi)
+{
+    wave_window_grow_by(i_max, lo, hi, 1);
+}
+
+/* Zeroes the interior of a (next) buffer outside [lo, hi], so it holds the
+   zeros the window skips over. */
+static inline void wave_window_clear(double *a, int i_max, int lo, int hi)
+{
+    if (lo > hi) {
+        memset(a + 1, 0, sizeof(double) * (size_t)(i_max - 2));
+        return;
+    }
+    memset(a + 1, 0, sizeof(double) * (size_t)(lo - 1));
+    memset(a + hi + 1, 0, sizeof(double) * (size_t)(i_max - 2 - hi));
+}
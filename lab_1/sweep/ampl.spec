@@ -0,0 +1,4 @@
+# The runs of test_ampl.sh (pthreads) and test_amp_openmp.sh (omp):
+# N = 10^3 .. 10^7 with 1000 steps. Those used 512 threads on a DAS node;
+# the thread counts of benchmark_prun.sh below let the small runs share it.
+backend=pthreads,omp i_max=1e3,1e4,1e5,1e6,1e7 t_max=1000 threads=1,2,4,8,16
@@ -0,0 +1,5 @@
+# The OpenMP schedules of benchmark_omp_schedules.sh (chunks in 64-point
+# blocks) over the sizes and thread counts of benchmark_prun.sh. Those
+# tuned t_max per size to run 10-100 s; here t_max shrinks with N instead.
+backend=omp init=sinfull i_max=1e3,1e4,1e5 t_max=100000 threads=1,2,4,8,16 sched=static:64,static:256,static:1024,dynamic:16,dynamic:64,dynamic:256,guided:16,guided:64,guided:256
+backend=omp init=sinfull i_max=1e6,1e7 t_max=1000 threads=1,2,4,8,16 sched=static:64,static:256,static:1024,dynamic:16,dynamic:64,dynamic:256,guided:16,guided:64,guided:256
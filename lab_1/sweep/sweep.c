@@ -0,0 +1,511 @@
+/*
+ * sweep.c
+ *
+ * In-process parameter sweep over the lab_1 solvers. The spec lists runs
+ * as key=value lists whose cross product is run; instead of one process
+ * per run, one after the other, the runs are packed onto disjoint sets of
+ * cores of this process and run side by side, each on its own thread with
+ * its own arena. Every finished run appends a row to one CSV file.
+ *
+ * Spec lines (# starts a comment, missing keys take the defaults):
+ *
+ *   backend=omp,pthreads i_max=1e3,1e6 t_max=1000 threads=1,4 \
+ *       init=sinfull sched=static:64,dynamic:16 reps=3
+ *
+ * sched= sets the OpenMP schedule of an omp run (kind:chunk, chunk in
+ * 64-point blocks like OMP_SCHEDULE); the other solvers run once instead
+ * of once per schedule, and seq and simd once instead of once per thread
+ * count.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "affinity.h"
+#include "arena.h"
+#include "backend.h"
+#include "coeff.h"
+#include "initial.h"
+#include "wave_kernels.h"
+
+#define MAX_VALUES 32
+#define MAX_RUNS 4096
+
+static const wave_backend_t *const backends[] = {
+    &wave_backend_pthreads,
+    &wave_backend_omp,
+    &wave_backend_seq,
+    &wave_backend_simd,
+};
+#define NBACKENDS ((int)(sizeof(backends) / sizeof(backends[0])))
+
+typedef struct {
+    const wave_backend_t *be;
+    char sched[24];        /* "" for the runtime default */
+    char init[16];
+    int i_max, t_max, threads, rep;
+    int ncores;            /* cores the run is given */
+    size_t bytes;          /* arena the run needs */
+
+    /* filled in by the scheduler and the run */
+    int placed;
+    cpu_set_t cores;
+    int concurrent;        /* runs active when it started */
+    double started, time, checksum;
+    int failed;
+    pthread_t thread;
+} run_t;
+
+/* Scheduler state, guarded by lock. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t finished = PTHREAD_COND_INITIALIZER;
+static int nactive;
+static size_t mem_used;
+static int *core_busy;
+static run_t **done;       /* finished runs not yet written out */
+static int ndone;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s spec_file [csv_file]\n", prog);
+    printf(" - spec_file: one line of key=value lists per group of runs; "
+            "keys:\n");
+    printf("   backend (pthreads), i_max, t_max (1000), threads (1), "
+            "init (sin),\n");
+    printf("   sched (OpenMP kind:chunk), reps (1)\n");
+    printf(" - csv_file: where the results go (default sweep.csv)\n");
+}
+
+/* Splits a comma-separated list in place. Returns the number of values. */
+static int split(char *list, char *values[MAX_VALUES])
+{
+    int n = 0;
+
+    for (char *v = strtok(list, ","); v && n < MAX_VALUES;
+         v = strtok(NULL, ","))
+        values[n++] = v;
+    return n;
+}
+
+/* Integer that may be written as 1e6. */
+static int parse_int(const char *s, int *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+
+    if (end == s || *end || v < 0 || v > 2147483647.0 || v != floor(v))
+        return -1;
+    *out = (int)v;
+    return 0;
+}
+
+static const wave_backend_t *find_backend(const char *name)
+{
+    for (int b = 0; b < NBACKENDS; ++b)
+        if (strcmp(backends[b]->name, name) == 0)
+            return backends[b];
+    return NULL;
+}
+
+/* Checks an OpenMP schedule of the form kind[:chunk]. */
+static int parse_sched(const char *s, omp_sched_t *kind, int *chunk)
+{
+    char name[16];
+    int n = 0;
+
+    *chunk = 0;
+    if (sscanf(s, "%15[a-z]%n", name, &n) != 1)
+        return -1;
+    if (s[n] == ':' && parse_int(s + n + 1, chunk) != 0)
+        return -1;
+    if (s[n] != ':' && s[n] != '\0')
+        return -1;
+    if (strcmp(name, "static") == 0) *kind = omp_sched_static;
+    else if (strcmp(name, "dynamic") == 0) *kind = omp_sched_dynamic;
+    else if (strcmp(name, "guided") == 0) *kind = omp_sched_guided;
+    else if (strcmp(name, "auto") == 0) *kind = omp_sched_auto;
+    else return -1;
+    return 0;
+}
+
+/*
+ * Expands one spec line into runs, appended at runs + *nruns. Returns 0,
+ * or -1 after reporting what is wrong with the line.
+ */
+static int parse_line(char *line, int lineno, int ncpus, run_t *runs,
+        int *nruns)
+{
+    char *backend = NULL, *i_max = NULL, *t_max = NULL, *threads = NULL;
+    char *init = NULL, *sched = NULL, *reps = NULL;
+    char *bv[MAX_VALUES], *iv[MAX_VALUES], *tv[MAX_VALUES];
+    char *nv[MAX_VALUES], *sv[MAX_VALUES];
+    char def_backend[] = "pthreads", def_t[] = "1000", def_n[] = "1";
+    char def_sched[] = "";
+    int nb, ni, nt, nn, ns, nrep = 1;
+
+    for (char *tok = strtok(line, " \t\r\n"); tok;
+         tok = strtok(NULL, " \t\r\n")) {
+        char *eq = strchr(tok, '=');
+        char **key;
+
+        if (!eq) {
+            fprintf(stderr, "line %d: expected key=value, got %s\n",
+                    lineno, tok);
+            return -1;
+        }
+        *eq = '\0';
+        if (strcmp(tok, "backend") == 0) key = &backend;
+        else if (strcmp(tok, "i_max") == 0) key = &i_max;
+        else if (strcmp(tok, "t_max") == 0) key = &t_max;
+        else if (strcmp(tok, "threads") == 0) key = &threads;
+        else if (strcmp(tok, "init") == 0) key = &init;
+        else if (strcmp(tok, "sched") == 0) key = &sched;
+        else if (strcmp(tok, "reps") == 0) key = &reps;
+        else {
+            fprintf(stderr, "line %d: unknown key %s\n", lineno, tok);
+            return -1;
+        }
+        *key = eq + 1;
+    }
+
+    if (!i_max) {
+        fprintf(stderr, "line %d: i_max missing\n", lineno);
+        return -1;
+    }
+    if (!init)
+        init = "sin";
+    if (reps && (parse_int(reps, &nrep) != 0 || nrep < 1)) {
+        fprintf(stderr, "line %d: bad reps=%s\n", lineno, reps);
+        return -1;
+    }
+
+    /* split after the whole line is tokenized; strtok is not reentrant */
+    nb = split(backend ? backend : def_backend, bv);
+    ni = split(i_max, iv);
+    nt = split(t_max ? t_max : def_t, tv);
+    nn = split(threads ? threads : def_n, nv);
+    ns = sched ? split(sched, sv) : 1;
+    if (!sched)
+        sv[0] = def_sched;
+
+    for (int b = 0; b < nb; ++b)
+    for (int s = 0; s < ns; ++s)
+    for (int i = 0; i < ni; ++i)
+    for (int t = 0; t < nt; ++t)
+    for (int n = 0; n < nn; ++n)
+    for (int rep = 0; rep < nrep; ++rep) {
+        run_t *r = &runs[*nruns];
+        const wave_backend_t *be = find_backend(bv[b]);
+        omp_sched_t kind;
+        int chunk, omp, seq;
+
+        if (!be) {
+            fprintf(stderr, "line %d: unknown backend %s\n", lineno, bv[b]);
+            return -1;
+        }
+        if (*sv[s] && parse_sched(sv[s], &kind, &chunk) != 0) {
+            fprintf(stderr, "line %d: bad sched %s\n", lineno, sv[s]);
+            return -1;
+        }
+
+        /* sched only means something to the OpenMP solver, and the
+           sequential ones use one core whatever threads says: run those
+           once instead of once per value */
+        omp = strcmp(be->name, "omp") == 0;
+        seq = be->run == wave_backend_seq.run
+              || be->run == wave_backend_simd.run;
+        if ((s > 0 && !omp) || (n > 0 && seq))
+            continue;
+
+        if (*nruns == MAX_RUNS) {
+            fprintf(stderr, "line %d: more than %d runs\n", lineno,
+                    MAX_RUNS);
+            return -1;
+        }
+        memset(r, 0, sizeof(*r));
+        r->be = be;
+        if (parse_int(iv[i], &r->i_max) != 0 || r->i_max < 3 ||
+                parse_int(tv[t], &r->t_max) != 0 || r->t_max < 1 ||
+                parse_int(nv[n], &r->threads) != 0 || r->threads < 1) {
+            fprintf(stderr, "line %d: bad i_max, t_max or threads\n",
+                    lineno);
+            return -1;
+        }
+        if (!wave_initial_known(init)) {
+            fprintf(stderr, "line %d: unknown init %s\n", lineno, init);
+            return -1;
+        }
+        strcpy(r->init, init);
+        snprintf(r->sched, sizeof(r->sched), "%s", omp ? sv[s] : "");
+        r->rep = rep;
+        if (seq)
+            r->threads = 1;
+
+        /* a run never gets more cores than there are */
+        r->ncores = r->threads;
+        if (r->ncores > ncpus)
+            r->ncores = ncpus;
+        r->bytes = 3 * WAVE_ARENA_CHUNK(sizeof(double) * (size_t)r->i_max);
+        ++*nruns;
+    }
+    return 0;
+}
+
+static void *run_main(void *arg)
+{
+    run_t *r = arg;
+    wave_arena_t arena = { 0 };
+    double *old, *cur, *next, *ret;
+
+    /* the solver's threads inherit this mask, so the run stays on its
+       cores without pinning */
+    pthread_setaffinity_np(pthread_self(), sizeof(r->cores), &r->cores);
+
+    if (*r->sched) {
+        omp_sched_t kind;
+        int chunk;
+        parse_sched(r->sched, &kind, &chunk);
+        omp_set_schedule(kind, chunk);
+    }
+
+    if (wave_arena_reserve(&arena, r->bytes) != 0 ||
+            !(old = wave_arena_alloc(&arena, r->bytes / 3, 0)) ||
+            !(cur = wave_arena_alloc(&arena, r->bytes / 3, 0)) ||
+            !(next = wave_arena_alloc(&arena, r->bytes / 3, 0))) {
+        r->failed = 1;
+    } else {
+        if (affinity_first_touch() && r->be->first_touch)
+            r->be->first_touch(r->i_max, r->threads, old, cur, next);
+        wave_initial(r->init, old, cur, r->i_max);
+
+        double t0 = now();
+        ret = r->be->run(r->i_max, r->t_max, r->threads, old, cur, next);
+        r->time = now() - t0;
+
+        /* sum of squares, to compare with runs that were not packed */
+        for (int i = 0; ret && i < r->i_max; ++i)
+            r->checksum += ret[i] * ret[i];
+        r->failed = !ret;
+    }
+    wave_arena_release(&arena);
+
+    pthread_mutex_lock(&lock);
+    done[ndone++] = r;
+    pthread_cond_signal(&finished);
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+/* Takes cores and memory for r if both are free. Called with lock held. */
+static int try_place(run_t *r, const int *cpus, int ncpus, size_t mem_max)
+{
+    int n = 0;
+
+    /* a run larger than the budget still runs, but alone */
+    if (mem_used + r->bytes > mem_max && nactive > 0)
+        return 0;
+    for (int c = 0; c < ncpus && n < r->ncores; ++c)
+        if (!core_busy[c])
+            ++n;
+    if (n < r->ncores)
+        return 0;
+
+    n = 0;
+    CPU_ZERO(&r->cores);
+    for (int c = 0; c < ncpus && n < r->ncores; ++c) {
+        if (!core_busy[c]) {
+            core_busy[c] = 1;
+            CPU_SET(cpus[c], &r->cores);
+            ++n;
+        }
+    }
+    mem_used += r->bytes;
+    r->concurrent = ++nactive;
+    return 1;
+}
+
+/* Gives r's cores and memory back. Called with lock held. */
+static void release(run_t *r, const int *cpus, int ncpus)
+{
+    for (int c = 0; c < ncpus; ++c)
+        if (CPU_ISSET(cpus[c], &r->cores))
+            core_busy[c] = 0;
+    mem_used -= r->bytes;
+    --nactive;
+}
+
+static void write_row(FILE *csv, const run_t *r, int index)
+{
+    int first = 1;
+
+    fprintf(csv, "%d,%s,%s,%s,%d,%d,%d,%d,%d,", index, r->be->name,
+            *r->sched ? r->sched : "default", r->init, r->i_max, r->t_max,
+            r->threads, r->rep, r->concurrent);
+    for (int c = 0; c < CPU_SETSIZE; ++c) {
+        if (CPU_ISSET(c, &r->cores)) {
+            fprintf(csv, first ? "%d" : " %d", c);
+            first = 0;
+        }
+    }
+    if (r->failed)
+        fprintf(csv, ",%.3f,NA,NA,NA,NA\n", r->started);
+    else
+        fprintf(csv, ",%.3f,%g,%g,%g,%.17g\n", r->started, r->time,
+                r->time / (1. * r->i_max * r->t_max),
+                1e-9 * r->i_max * r->t_max / r->time, r->checksum);
+    fflush(csv);
+}
+
+int main(int argc, char *argv[])
+{
+    static run_t runs[MAX_RUNS];
+    int nruns = 0, next_run = 0, nwritten = 0;
+    int cpus[CPU_SETSIZE], ncpus = 0;
+    const char *csv_name = (argc > 2) ? argv[2] : "sweep.csv";
+    char line[1024];
+    cpu_set_t set;
+    FILE *fp, *csv;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* the cores this process may use (taskset restricts the sweep) */
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &set))
+                cpus[ncpus++] = c;
+    }
+    if (ncpus == 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int c = 0; c < n && c < CPU_SETSIZE; ++c)
+            cpus[ncpus++] = c;
+    }
+
+    if (!(fp = fopen(argv[1], "r"))) {
+        fprintf(stderr, "Cannot open %s: %s\n", argv[1], strerror(errno));
+        return EXIT_FAILURE;
+    }
+    for (int lineno = 1; fgets(line, sizeof(line), fp); ++lineno) {
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        if (strspn(line, " \t\r\n") == strlen(line))
+            continue;
+        if (parse_line(line, lineno, ncpus, runs, &nruns) != 0) {
+            fclose(fp);
+            return EXIT_FAILURE;
+        }
+    }
+    fclose(fp);
+
+    /* Settings that would make concurrent runs step on each other: pinning
+       to absolute CPUs, per-run output files and the per-size coefficient
+       cache. */
+    if (getenv("WAVE_COEFF")) {
+        fprintf(stderr, "WAVE_COEFF is not supported in a sweep.\n");
+        return EXIT_FAILURE;
+    }
+    if (getenv("WAVE_AFFINITY")) {
+        fprintf(stderr, "Ignoring WAVE_AFFINITY; every run is kept on its "
+                "own cores.\n");
+        unsetenv("WAVE_AFFINITY");
+    }
+    if (getenv("WAVE_REDUCE")) {
+        fprintf(stderr, "Ignoring WAVE_REDUCE in a sweep.\n");
+        unsetenv("WAVE_REDUCE");
+    }
+    if (getenv("OMP_PROC_BIND") || getenv("OMP_PLACES"))
+        fprintf(stderr, "OMP_PROC_BIND/OMP_PLACES pin to fixed places; "
+                "unset them so omp runs stay on their cores.\n");
+
+    /* read the cached settings now, before the runs race for them */
+    wave_kernel_select();
+    wave_order();
+    wave_cache_size();
+
+    /* half the physical memory for the runs' arrays */
+    size_t mem_max = (size_t)sysconf(_SC_PHYS_PAGES)
+                   * (size_t)sysconf(_SC_PAGESIZE) / 2;
+
+    if (!(csv = fopen(csv_name, "w"))) {
+        fprintf(stderr, "Cannot open %s: %s\n", csv_name, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    fprintf(csv, "run,backend,sched,init,N,steps,threads,rep,concurrent,"
+            "cores,started,raw_time,normalized_time,gupdates,checksum\n");
+
+    core_busy = calloc(ncpus, sizeof(int));
+    done = calloc(nruns ? nruns : 1, sizeof(run_t *));
+    if (!core_busy || !done) {
+        fprintf(stderr, "Could not allocate enough memory, aborting.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Sweep: %d runs on %d cores\n", nruns, ncpus);
+    const double t0 = now();
+
+    /*
+     * Runs start in spec order; when the next one does not fit on the free
+     * cores, a later one that does is started instead, so small runs fill
+     * the gaps the large ones leave.
+     */
+    pthread_mutex_lock(&lock);
+    while (nwritten < nruns) {
+        for (int i = next_run; i < nruns; ++i) {
+            run_t *r = &runs[i];
+
+            if (r->placed || !try_place(r, cpus, ncpus, mem_max))
+                continue;
+            r->placed = 1;
+            r->started = now() - t0;
+            if (pthread_create(&r->thread, NULL, run_main, r) != 0) {
+                fprintf(stderr, "Cannot start run %d, aborting.\n", i);
+                return EXIT_FAILURE;
+            }
+        }
+        while (next_run < nruns && runs[next_run].placed)
+            ++next_run;
+
+        while (ndone == 0)
+            pthread_cond_wait(&finished, &lock);
+        while (ndone > 0) {
+            run_t *r = done[--ndone];
+
+            release(r, cpus, ncpus);
+            pthread_join(r->thread, NULL);
+            write_row(csv, r, (int)(r - runs));
+            ++nwritten;
+            printf("[%d/%d] %s N=%d steps=%d threads=%d: %s\n", nwritten,
+                   nruns, r->be->name, r->i_max, r->t_max, r->threads,
+                   r->failed ? "failed" : "done");
+            fflush(stdout);
+        }
+    }
+    pthread_mutex_unlock(&lock);
+
+    printf("Sweep took %g seconds\n", now() - t0);
+    printf("Results saved to %s\n", csv_name);
+    fclose(csv);
+    free(done);
+    free(core_busy);
+    return EXIT_SUCCESS;
+}
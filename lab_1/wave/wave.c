@@ -0,0 +1,26 @@
+/*
+ * wave.c
+ *
+ * One program for every lab_1 solver: --backend=seq|simd|pthreads|omp
+ * picks the solver at run time, with the same setup, timing and output as
+ * the assignment binaries (see ../common/driver.h).
+ */
+
+#include <stdlib.h>
+
+#include "backend.h"
+#include "driver.h"
+
+/* pthreads first, as in assign_1_1_framework */
+static const wave_backend_t *const backends[] = {
+    &wave_backend_pthreads,
+    &wave_backend_omp,
+    &wave_backend_seq,
+    &wave_backend_simd,
+};
+
+int main(int argc, char *argv[])
+{
+    return wave_driver_main(argc, argv, backends,
+            (int)(sizeof(backends) / sizeof(backends[0])));
+}
@@ -0,0 +1,154 @@
+/*
+ * simulate2d.c
+ *
+ * Tiled OpenMP sweep of the 2D scheme. The interior is cut into tiles of
+ * TILE_ROWS rows by TILE_COLS points; a tile is swept row by row, so the
+ * three rows of cur a row reads stay in cache between rows and every point
+ * of cur is loaded from memory about once per step (plus the two halo
+ * rows per tile). The inner loops are the row kernels of
+ * ../common/wave_kernels.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "affinity.h"
+#include "simulate2d.h"
+#include "wave_kernels.h"
+
+/* Default tile: five row segments of 4096 points (cur above, at and
+   below, old and next) take 160 KiB, within the L2 of any recent core.
+   L1-sized tiles cut the streams the hardware prefetcher follows into
+   pieces too short to pay off and were slower. TILE_COLS is a multiple of
+   the cache line so every tile starts aligned; TILE_ROWS sets the work
+   per tile. */
+#define TILE_ROWS 16
+#define TILE_COLS 4096
+
+/* Doubles per cache line */
+#define LINE 8
+
+size_t wave2d_pitch(int nx)
+{
+    size_t pitch = ((size_t)nx + LINE - 1) / LINE * LINE;
+
+    /* a pitch of 4 KiB multiples maps the rows of a column onto the same
+       sets */
+    if (pitch % 512 == 0)
+        pitch += LINE;
+    return pitch;
+}
+
+/* Tile size from WAVE_TILE, clamped to the interior. */
+static void tile_size(int nx, int ny, int *rows, int *cols)
+{
+    const char *env = getenv("WAVE_TILE");
+    int r = TILE_ROWS, c = TILE_COLS;
+
+    if (env && strcmp(env, "off") == 0) {
+        r = 1;
+        c = nx;
+    } else if (env && *env) {
+        if (sscanf(env, "%dx%d", &r, &c) != 2 || r < 1 || c < 1) {
+            fprintf(stderr, "Ignoring WAVE_TILE=%s.\n", env);
+            r = TILE_ROWS;
+            c = TILE_COLS;
+        } else if (c % LINE) {
+            c = (c + LINE - 1) / LINE * LINE;
+        }
+    }
+    *rows = (r > ny - 2) ? ny - 2 : r;
+    *cols = (c > nx - 2) ? nx - 2 : c;
+}
+
+void simulate2d_first_touch(int nx, int ny, size_t pitch, int num_threads,
+        double *old, double *cur, double *next)
+{
+    int rows, cols;
+
+    tile_size(nx, ny, &rows, &cols);
+    const int nby = (ny - 2 + rows - 1) / rows;
+    const int nbx = (nx - 2 + cols - 1) / cols;
+
+    omp_set_num_threads(num_threads);
+
+    #pragma omp parallel default(none) shared(ny, nx, pitch, old, cur, \
+            next, rows, cols, nby, nbx)
+    {
+        affinity_pin(omp_get_thread_num());
+
+        /* the same loop and schedule as the sweep, rim cells included
+           with the tiles next to them */
+        #pragma omp for collapse(2) schedule(static)
+        for (int by = 0; by < nby; ++by) {
+            for (int bx = 0; bx < nbx; ++bx) {
+                int i0 = (by == 0) ? 0 : 1 + by * rows;
+                int i1 = (by == nby - 1) ? ny - 1 : by * rows + rows;
+                int j0 = (bx == 0) ? 0 : 1 + bx * cols;
+                int j1 = (bx == nbx - 1) ? nx - 1 : bx * cols + cols;
+                size_t bytes = sizeof(double) * (size_t)(j1 - j0 + 1);
+
+                for (int i = i0; i <= i1; ++i) {
+                    size_t at = (size_t)i * pitch + j0;
+                    memset(old + at, 0, bytes);
+                    memset(cur + at, 0, bytes);
+                    memset(next + at, 0, bytes);
+                }
+            }
+        }
+    }
+}
+
+double *simulate2d(int nx, int ny, size_t pitch, int t_max, int num_threads,
+        double *old, double *cur, double *next)
+{
+    double *bufs[3] = { old, cur, next };
+    wave_kernel_2d_t kernel = wave_kernel_2d();
+    int rows, cols;
+
+    if (t_max <= 0 || nx < 3 || ny < 3)
+        return cur;
+
+    tile_size(nx, ny, &rows, &cols);
+    const int nby = (ny - 2 + rows - 1) / rows;
+    const int nbx = (nx - 2 + cols - 1) / cols;
+    const long lp = (long)pitch;
+
+    omp_set_num_threads(num_threads);
+
+    /* The rim is never written, so it stays zero in all three grids, and
+       picking the grids by t % 3 leaves nothing to rotate: the implicit
+       barrier of the tile loop is the only one per step. */
+    #pragma omp parallel default(none) shared(nx, ny, pitch, lp, t_max, \
+            bufs, kernel, rows, cols, nby, nbx)
+    {
+        affinity_pin(omp_get_thread_num());
+
+        for (int t = 0; t < t_max; ++t) {
+            const double *o = bufs[t % 3];
+            const double *c = bufs[(t + 1) % 3];
+            double *n = bufs[(t + 2) % 3];
+
+            #pragma omp for collapse(2) schedule(static)
+            for (int by = 0; by < nby; ++by) {
+                for (int bx = 0; bx < nbx; ++bx) {
+                    int i0 = 1 + by * rows;
+                    int i1 = (i0 + rows - 1 > ny - 2) ? ny - 2
+                                                      : i0 + rows - 1;
+                    int j0 = 1 + bx * cols;
+                    int j1 = (j0 + cols - 1 > nx - 2) ? nx - 2
+                                                      : j0 + cols - 1;
+
+                    for (int i = i0; i <= i1; ++i) {
+                        size_t row = (size_t)i * pitch;
+                        kernel(n + row, c + row, o + row, lp, j0, j1);
+                    }
+                }
+            }
+        }
+    }
+
+    return bufs[(t_max + 1) % 3];
+}
@@ -0,0 +1,37 @@
+/*
+ * simulate2d.h
+ *
+ * 2D wave solver for membranes: the 1D scheme with the 5-point Laplacian,
+ *   next = 2 cur - old + c (left + right + up + down - 4 cur),
+ * on an nx x ny grid whose rim is fixed at zero. The three grids are
+ * picked by t % 3 like the 1D buffers, and every step is swept in tiles
+ * by an OpenMP team (see simulate2d.c).
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Row pitch in doubles for rows of nx points: a whole number of cache
+ * lines, and never a multiple of 4 KiB, so the rows above and below a
+ * point do not compete for the same cache sets. Allocate every grid with
+ * ny * pitch doubles, placed so that element 1 of row 0 starts a cache
+ * line (wave_arena_alloc() with lead sizeof(double)); the interior of
+ * every row is then aligned.
+ */
+size_t wave2d_pitch(int nx);
+
+/* Zeroes the grids with the tile-to-thread mapping of simulate2d(), so
+   the pages land on the node of the thread that computes them. */
+void simulate2d_first_touch(int nx, int ny, size_t pitch, int num_threads,
+        double *old, double *cur, double *next);
+
+/*
+ * Runs t_max steps on grids of ny rows of pitch doubles, with generation
+ * t-1 in old and t in cur, and returns the grid holding generation t_max
+ * (bufs[(t_max + 1) % 3]). WAVE_TILE=RxC sets the tile to R rows of C
+ * points (default 16x4096); WAVE_TILE=off sweeps whole rows.
+ */
+double *simulate2d(int nx, int ny, size_t pitch, int t_max, int num_threads,
+        double *old, double *cur, double *next);
@@ -0,0 +1,161 @@
+/*
+ * wave2d.c
+ *
+ * Driver of the 2D solver: sets up the grids, times the run and reports
+ * the throughput in grid-point updates per second, the unit the 1D
+ * drivers report too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "affinity.h"
+#include "arena.h"
+#include "simulate2d.h"
+#include "timer.h"
+
+#define PI 3.14159265358979323846
+
+/* Larger grids are not written to result.txt. */
+#define MAX_WRITE (1 << 20)
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s nx ny t_max num_threads [initial_data]\n", prog);
+    printf(" - nx, ny: grid points per row and per column, should be >2\n");
+    printf(" - t_max: number of discrete timesteps, should be >=1\n");
+    printf(" - num_threads: number of threads to use for simulation, "
+            "should be >=1\n");
+    printf(" - initial_data: select what data should be used for the first "
+            "two generations.\n");
+    printf("   Available options are:\n");
+    printf("    * gauss: a gauss bump in the middle of the membrane.\n");
+    printf("    * sin: the lowest mode, sin(pi x) sin(pi y).\n");
+}
+
+/* Fills both generations of the interior with f(x, y), x and y in [0, 1]. */
+static void fill(double *old, double *cur, int nx, int ny, size_t pitch,
+        int gauss)
+{
+    const double s = 1.0 / 16.0;
+
+    for (int i = 1; i < ny - 1; ++i) {
+        double y = (double)i / (ny - 1);
+        for (int j = 1; j < nx - 1; ++j) {
+            double x = (double)j / (nx - 1);
+            double v = gauss
+                ? exp(-((x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5))
+                      / (2 * s * s))
+                : sin(PI * x) * sin(PI * y);
+            old[(size_t)i * pitch + j] = v;
+            cur[(size_t)i * pitch + j] = v;
+        }
+    }
+}
+
+/* Writes the grid as one line of nx values per row (gnuplot's matrix
+   format). */
+static void write_grid(const char *name, const double *g, int nx, int ny,
+        size_t pitch)
+{
+    FILE *fp = fopen(name, "w");
+
+    if (!fp) {
+        perror(name);
+        return;
+    }
+    for (int i = 0; i < ny; ++i) {
+        for (int j = 0; j < nx; ++j)
+            fprintf(fp, (j + 1 < nx) ? "%f " : "%f\n",
+                    g[(size_t)i * pitch + j]);
+    }
+    fclose(fp);
+}
+
+int main(int argc, char *argv[])
+{
+    int nx, ny, t_max, num_threads, gauss = 1;
+    wave_arena_t arena = { 0 };
+    double *old, *cur, *next, *ret;
+    double time, sum = 0.0;
+
+    if (argc < 5) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    nx = atoi(argv[1]);
+    ny = atoi(argv[2]);
+    t_max = atoi(argv[3]);
+    num_threads = atoi(argv[4]);
+
+    if (nx < 3 || ny < 3) {
+        printf("argument error: nx and ny should be >2.\n");
+        return EXIT_FAILURE;
+    }
+    if (t_max < 1) {
+        printf("argument error: t_max should be >=1.\n");
+        return EXIT_FAILURE;
+    }
+    if (num_threads < 1) {
+        printf("argument error: num_threads should be >=1.\n");
+        return EXIT_FAILURE;
+    }
+    if (argc > 5) {
+        if (strcmp(argv[5], "sin") == 0) {
+            gauss = 0;
+        } else if (strcmp(argv[5], "gauss") != 0) {
+            printf("Unknown initial mode: %s.\n", argv[5]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* three grids with aligned row interiors, all from one arena */
+    const size_t pitch = wave2d_pitch(nx);
+    const size_t bytes = sizeof(double) * pitch * (size_t)ny;
+    if (wave_arena_reserve(&arena, 3 * WAVE_ARENA_CHUNK(bytes)) != 0) {
+        fprintf(stderr, "Could not map the grid arena, aborting.\n");
+        return EXIT_FAILURE;
+    }
+    old = wave_arena_alloc(&arena, bytes, sizeof(double));
+    cur = wave_arena_alloc(&arena, bytes, sizeof(double));
+    next = wave_arena_alloc(&arena, bytes, sizeof(double));
+    if (!old || !cur || !next) {
+        fprintf(stderr, "Could not allocate enough memory, aborting.\n");
+        return EXIT_FAILURE;
+    }
+
+    if (affinity_first_touch())
+        simulate2d_first_touch(nx, ny, pitch, num_threads, old, cur, next);
+    fill(old, cur, nx, ny, pitch, gauss);
+
+    timer_start();
+    ret = simulate2d(nx, ny, pitch, t_max, num_threads, old, cur, next);
+    time = timer_end();
+
+    const double points = (double)nx * ny;
+    printf("Took %g seconds\n", time);
+    printf("Normalized: %g seconds\n", time / (points * t_max));
+    printf("Throughput: %g Gupdates/s\n", points * t_max / time * 1e-9);
+    wave_arena_report(&arena, "main");
+
+    /* sum of squares, to compare runs that do not write the grid */
+    for (int i = 1; i < ny - 1; ++i) {
+        for (int j = 1; j < nx - 1; ++j) {
+            double v = ret[(size_t)i * pitch + j];
+            sum += v * v;
+        }
+    }
+    printf("Checksum: %.17g\n", sum);
+
+    if (points <= MAX_WRITE)
+        write_grid("result.txt", ret, nx, ny, pitch);
+    else
+        printf("Grid larger than %d points; result.txt not written.\n",
+               MAX_WRITE);
+
+    wave_arena_release(&arena);
+    return EXIT_SUCCESS;
+}
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <algorithm>
 
 #include "file.hh"
 #include "timer.hh"
@@ -87,6 +88,18 @@ int main(int argc, char* argv[]) {
     fill(old_array, 1, i_max / 4, 0, 2 * M_PI);
     fill(current_array, 2, i_max / 4, 0, 2 * M_PI);
 
+    // Keep the GPU input around for the double reference of reduced
+    // precision runs
+    const wave_precision_t precision = wave_precision();
+    double *ref_old = NULL, *ref_current = NULL, *ref_next = NULL;
+    if (precision != WAVE_DOUBLE) {
+        ref_old = new double[i_max];
+        ref_current = new double[i_max];
+        ref_next = new double[i_max]();
+        copy(old_array, old_array + i_max, ref_old);
+        copy(current_array, current_array + i_max, ref_current);
+    }
+
     // Time & run the wave equation simulation in simulate.cc
     // Initialize the timer
     timer waveTimer("GPU wave timer");
@@ -101,6 +114,24 @@ int main(int argc, char* argv[]) {
     cout << waveTimer;
     file_write_double_array("result.txt", result_array, i_max);
 
+    // Report how far the reduced precision result is from double
+    if (precision != WAVE_DOUBLE) {
+        double *ref = simulateSeq(i_max, t_max, 1, ref_old, ref_current,
+                                  ref_next);
+        double max_abs = 0, max_ref = 0;
+        for (long i = 0; i < i_max; i++) {
+            max_abs = max(max_abs, fabs(result_array[i] - ref[i]));
+            max_ref = max(max_ref, fabs(ref[i]));
+        }
+        cout << "Precision " << (precision == WAVE_FLOAT ? "float" : "mixed")
+             << ": max abs deviation " << max_abs
+             << ", max rel deviation " << (max_ref > 0 ? max_abs / max_ref : 0)
+             << endl;
+        delete[] ref_old;
+        delete[] ref_current;
+        delete[] ref_next;
+    }
+
     // Clean the arrays
     delete[] old_array;
     delete[] current_array;
@@ -12,6 +12,7 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "simulate.hh"
 
@@ -46,51 +47,96 @@ static void checkCudaCall(cudaError_t result) {
  * Each thread computes one element of the next array. The boundary elements
  * (index 0 and i_max-1) are kept at 0.
  *
+ * Store is the element type kept in GPU memory and Acc the type the update
+ * is computed in: double/double is the reference, float/float halves the
+ * memory traffic and float/double keeps the accumulation in double.
+ *
  * Parameters:
  *   old_array: wave values at time t-1
  *   current_array: wave values at time t
  *   next_array: output array for wave values at time t+1
  *   i_max: number of data points in the wave
  */
-__global__ void waveEquationKernel(double* old_array, double* current_array,
-                                    double* next_array, const long i_max) {
+template <typename Store, typename Acc>
+__global__ void waveEquationKernel(Store* old_array, Store* current_array,
+                                    Store* next_array, const long i_max) {
     int block_index = blockIdx.x;
     int block_dimension = blockDim.x;
     int thread_index = threadIdx.x;
     // Calculate the index for this thread
     unsigned long i = block_index * block_dimension + thread_index;
 
-    const double C = 0.15;
+    const Acc C = 0.15;
 
     // Check if this thread is within bounds and not on the boundary
     // Boundaries (i=0 and i=i_max-1) remain fixed at 0
     if (i > 0 && i < i_max - 1) {
+        Acc left = current_array[i-1];
+        Acc mid = current_array[i];
+        Acc right = current_array[i+1];
+        Acc prev = old_array[i];
+
         // Compute the wave equation for this point
         // A[i,t+1] = 2*A[i,t] - A[i,t-1] + c*(A[i-1,t] - 2*A[i,t] + A[i+1,t])
-        next_array[i] = 2 * current_array[i] - old_array[i]
-                + C * (current_array[i-1] - (2*current_array[i] - current_array[i+1]));
+        next_array[i] = (Store)(2 * mid - prev
+                + C * (left - (2*mid - right)));
     }
 }
 
 
-/* Function that will simulate the wave equation, parallelized using CUDA.
- *
- * i_max: how many data points are on a single wave
- * t_max: how many iterations the simulation should run
- * block_size: how many threads per block you should use
- * old_array: array of size i_max filled with data for t-1
- * current_array: array of size i_max filled with data for t
- * next_array: array of size i_max. You should fill this with t+1
+/* Copies n doubles from the host to a device array of type Store,
+ * converting on the host when Store is narrower than double.
  */
-double *simulate(const long i_max, const long t_max, const long block_size,
-                 double *old_array, double *current_array, double *next_array) {
+template <typename Store>
+static void copyToDevice(Store *device, const double *host, long n) {
+    Store *stage = new Store[n];
+    for (long i = 0; i < n; i++) {
+        stage[i] = (Store) host[i];
+    }
+    checkCudaCall(cudaMemcpy(device, stage, n * sizeof(Store),
+        cudaMemcpyHostToDevice));
+    delete[] stage;
+}
+
+template <>
+void copyToDevice<double>(double *device, const double *host, long n) {
+    checkCudaCall(cudaMemcpy(device, host, n * sizeof(double),
+        cudaMemcpyHostToDevice));
+}
+
+/* Copies n elements of type Store from the device back into host doubles. */
+template <typename Store>
+static void copyToHost(double *host, const Store *device, long n) {
+    Store *stage = new Store[n];
+    checkCudaCall(cudaMemcpy(stage, device, n * sizeof(Store),
+        cudaMemcpyDeviceToHost));
+    for (long i = 0; i < n; i++) {
+        host[i] = stage[i];
+    }
+    delete[] stage;
+}
+
+template <>
+void copyToHost<double>(double *host, const double *device, long n) {
+    checkCudaCall(cudaMemcpy(host, device, n * sizeof(double),
+        cudaMemcpyDeviceToHost));
+}
+
+
+/* Runs the simulation with Store-typed device arrays, see
+ * waveEquationKernel. The host arrays stay double.
+ */
+template <typename Store, typename Acc>
+static double *simulateTyped(const long i_max, const long t_max,
+                             const long block_size, double *old_array,
+                             double *current_array) {
     // Allocate device memory (memory on the GPU) for the three arrays
-    double* device_old = NULL;
-    double* device_current = NULL;
-    double* device_next = NULL;
+    Store* device_old = NULL;
+    Store* device_current = NULL;
+    Store* device_next = NULL;
 
     // Array size calculation in bytes
-    size_t array_size = i_max * sizeof(double);
+    size_t array_size = i_max * sizeof(Store);
 
     // Allocate memory on the GPU for old_array
     checkCudaCall(cudaMalloc((void **) &device_old, array_size));
@@ -117,15 +163,13 @@ double *simulate(const long i_max, const long t_max, const long block_size,
     }
 
     // Copy the arrays from the CPU to the GPU to get the two previous time steps
-    checkCudaCall(cudaMemcpy(device_old, old_array, array_size,
-        cudaMemcpyHostToDevice));
-    checkCudaCall(cudaMemcpy(device_current, current_array, array_size,
-        cudaMemcpyHostToDevice));
+    copyToDevice(device_old, old_array, i_max);
+    copyToDevice(device_current, current_array, i_max);
 
     long num_blocks = (i_max + block_size - 1) / block_size;
 
     for (long t = 0; t < t_max; t++) {
-        waveEquationKernel<<<num_blocks, block_size>>>(device_old,
+        waveEquationKernel<Store, Acc><<<num_blocks, block_size>>>(device_old,
             device_current, device_next, i_max);
 
         // Check for kernel launch errors
@@ -135,7 +179,7 @@ double *simulate(const long i_max, const long t_max, const long block_size,
         checkCudaCall(cudaDeviceSynchronize());
 
         // Rotate arrays for next iteration
-        double* temp = device_old;
+        Store* temp = device_old;
         device_old = device_current;
         device_current = device_next;
         device_next = temp;
@@ -143,8 +187,7 @@ double *simulate(const long i_max, const long t_max, const long block_size,
 
     // After t_max iterations, deviceCurrent contains the final result
     // Copy the result back from the GPU to the CPU (the host)
-    checkCudaCall(cudaMemcpy(current_array, device_current, array_size,
-        cudaMemcpyDeviceToHost));
+    copyToHost(current_array, device_current, i_max);
 
     // Free device memory
     checkCudaCall(cudaFree(device_old));
@@ -154,6 +197,44 @@ double *simulate(const long i_max, const long t_max, const long block_size,
     return current_array;
 }
 
+/* Precision selected through WAVE_PRECISION (double, float or mixed). */
+wave_precision_t wave_precision() {
+    const char *env = getenv("WAVE_PRECISION");
+
+    if (env && strcmp(env, "float") == 0) {
+        return WAVE_FLOAT;
+    }
+    if (env && strcmp(env, "mixed") == 0) {
+        return WAVE_MIXED;
+    }
+    return WAVE_DOUBLE;
+}
+
+
+/* Function that will simulate the wave equation, parallelized using CUDA.
+ *
+ * i_max: how many data points are on a single wave
+ * t_max: how many iterations the simulation should run
+ * block_size: how many threads per block you should use
+ * old_array: array of size i_max filled with data for t-1
+ * current_array: array of size i_max filled with data for t
+ * next_array: array of size i_max. You should fill this with t+1
+ */
+double *simulate(const long i_max, const long t_max, const long block_size,
+                 double *old_array, double *current_array, double *next_array) {
+    switch (wave_precision()) {
+    case WAVE_FLOAT:
+        return simulateTyped<float, float>(i_max, t_max, block_size,
+            old_array, current_array);
+    case WAVE_MIXED:
+        return simulateTyped<float, double>(i_max, t_max, block_size,
+            old_array, current_array);
+    default:
+        return simulateTyped<double, double>(i_max, t_max, block_size,
+            old_array, current_array);
+    }
+}
+
 /*
  * Executes the entire simulation in sequence.
  *
@@ -8,6 +8,15 @@
 #ifndef SIMULATE_HH
 #define SIMULATE_HH
 
+/* Storage precision of the GPU arrays, selected with WAVE_PRECISION. */
+enum wave_precision_t {
+    WAVE_DOUBLE,   /* double storage and arithmetic */
+    WAVE_FLOAT,    /* float storage and arithmetic */
+    WAVE_MIXED     /* float storage, double accumulation */
+};
+
+wave_precision_t wave_precision();
+
 /* Function that will simulate the wave equation, parallelized using CUDA.
  *
  * i_max: how many data points are on a single wave
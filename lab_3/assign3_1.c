@@ -10,6 +10,7 @@
 #include <math.h>
 #include <mpi.h>
 
+#include "arena.h"
 #include "file.h"
 #include "timer.h"
 #include "simulate.h"
@@ -50,8 +51,12 @@ void fill(double *array, int offset, int range, double sample_start,
 int main(int argc, char *argv[])
 {
     double *old, *current, *next, *ret;
-    int t_max, i_max;
+    int t_max, i_max, buffers;
     double time;
+    double *ref_old = NULL, *ref_current = NULL, *ref_next = NULL;
+    wave_precision_t precision = WAVE_DOUBLE;
+    wave_arena_t arena = { 0 };
+    size_t bytes;
 
     int rank, size;
 
@@ -99,21 +104,33 @@ int main(int argc, char *argv[])
      * Allocate and initialize buffers.
      *
      * Only rank 0 actually needs the full global arrays; other ranks will
-     * receive their local pieces inside simulate() via MPI_Scatterv.
+     * receive their local pieces inside simulate() via MPI_Scatterv. The
+     * global arrays (and the reference copies) come from one huge-page
+     * arena.
      */
     if (rank == 0) {
-        old = malloc(i_max * sizeof(double));
-        current = malloc(i_max * sizeof(double));
-        next = malloc(i_max * sizeof(double));
+        /* WAVE_BUFFERS=2: no next array, every rank updates old in place */
+        buffers = getenv("WAVE_BUFFERS") ? atoi(getenv("WAVE_BUFFERS")) : 3;
+        precision = wave_precision();
+        bytes = i_max * sizeof(double);
+        if (wave_arena_reserve(&arena, (precision != WAVE_DOUBLE ? 6 : 3)
+                               * WAVE_ARENA_CHUNK(bytes)) != 0) {
+            fprintf(stderr, "Could not map the buffer arena, aborting.\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        old = wave_arena_alloc(&arena, bytes, 0);
+        current = wave_arena_alloc(&arena, bytes, 0);
+        next = (buffers == 2) ? NULL : wave_arena_alloc(&arena, bytes, 0);
 
-        if (old == NULL || current == NULL || next == NULL) {
+        if (old == NULL || current == NULL || (next == NULL && buffers != 2)) {
             fprintf(stderr, "Could not allocate enough memory, aborting.\n");
             MPI_Abort(MPI_COMM_WORLD, 1);
         }
 
         memset(old, 0, i_max * sizeof(double));
         memset(current, 0, i_max * sizeof(double));
-        memset(next, 0, i_max * sizeof(double));
+        if (next != NULL)
+            memset(next, 0, i_max * sizeof(double));
 
         /* How should we fill our first two generations? */
         if (argc > 3) {
@@ -144,11 +161,28 @@ int main(int argc, char *argv[])
             fill(old, 1, i_max/4, 0, 2*3.14, sin);
             fill(current, 2, i_max/4, 0, 2*3.14, sin);
         }
+
+        /* Keep the initial data around for the double reference run. */
+        if (precision != WAVE_DOUBLE) {
+            ref_old = wave_arena_alloc(&arena, bytes, 0);
+            ref_current = wave_arena_alloc(&arena, bytes, 0);
+            ref_next = wave_arena_alloc(&arena, bytes, 0);
+            if (ref_old == NULL || ref_current == NULL || ref_next == NULL) {
+                fprintf(stderr, "Could not allocate reference buffers.\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            memcpy(ref_old, old, i_max * sizeof(double));
+            memcpy(ref_current, current, i_max * sizeof(double));
+        }
     } else {
         /* Other ranks do not hold the full arrays; simulate() will Scatterv. */
         old = current = next = NULL;
     }
 
+    /* Read WAVE_COEFF before the clock starts. */
+    if (rank == 0)
+        wave_coeff(i_max);
+
     /* Make sure all ranks start timing at the same moment. */
     MPI_Barrier(MPI_COMM_WORLD);
     timer_start();
@@ -162,12 +196,23 @@ int main(int argc, char *argv[])
     if (rank == 0) {
         printf("Took %g seconds\n", time);
         printf("Normalized: %g seconds\n", time / (1. * i_max * t_max));
+        wave_arena_report(&arena, "rank 0 main");
 
         file_write_double_array("result.txt", ret, i_max);
 
-        free(old);
-        free(current);
-        free(next);
+        /* simulate() runs a varying c and the fourth-order stencil in
+           double only */
+        const wave_used_t *used = simulate_used();
+        const char *label = wave_precision_name(precision);
+        if (precision != WAVE_DOUBLE && used->precision == WAVE_DOUBLE) {
+            printf("Precision %s: fell back to double\n", label);
+        } else if (precision != WAVE_DOUBLE) {
+            double *ref = wave_reference(i_max, t_max, used->order,
+                    used->coef, ref_old, ref_current, ref_next);
+            wave_report_deviation(label, ref, ret, i_max);
+        }
+
+        wave_arena_release(&arena);
     }
 
     MPI_Finalize();
@@ -14,14 +14,228 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <mpi.h>
 
+#include "arena.h"
 #include "simulate.h"
 
 
 /* Wave propagation constant (lambda^2). */
 const double C2 = 0.15;
 
+/* Halo cells on each side of the local arrays: enough for the fourth-order
+   stencil, of which the second-order one uses the inner cell. */
+#define HALO 2
+
+/* Settings of the last simulate() call, see simulate_used(). */
+static wave_used_t used = { WAVE_DOUBLE, 2, NULL };
+
+/* Local arrays of this rank; the mapping is kept for the next simulate()
+   call and released at exit. */
+static wave_arena_t local_arena;
+
+/* Updates local points j_begin .. j_end of one time step. Points on the
+   global boundary are kept at zero. Buffers are typed by precision; coef
+   holds the local coefficients for update_coef and is NULL otherwise. */
+typedef void (*update_fn_t)(void *next, const void *cur, const void *old,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max);
+
+static void update_double(void *next_v, const void *cur_v, const void *old_v,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max)
+{
+    (void)coef;
+    double *next_local = next_v;
+    const double *curr_local = cur_v, *old_local = old_v;
+
+    for (int j = j_begin; j <= j_end; j++) {
+        int i_global = global_start + (j - HALO);
+        if (i_global == 0 || i_global == i_max - 1) {
+            next_local[j] = 0.0;
+        } else {
+            double u_im1 = curr_local[j - 1];
+            double u_i   = curr_local[j];
+            double u_ip1 = curr_local[j + 1];
+
+            next_local[j] =
+                2.0 * u_i
+                -      old_local[j]
+                + C2 * (u_im1 - 2.0 * u_i + u_ip1);
+        }
+    }
+}
+
+/* update_double with the coefficient of every point (WAVE_COEFF) */
+static void update_coef(void *next_v, const void *cur_v, const void *old_v,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max)
+{
+    double *next_local = next_v;
+    const double *curr_local = cur_v, *old_local = old_v;
+
+    for (int j = j_begin; j <= j_end; j++) {
+        int i_global = global_start + (j - HALO);
+        if (i_global == 0 || i_global == i_max - 1) {
+            next_local[j] = 0.0;
+        } else {
+            double u_im1 = curr_local[j - 1];
+            double u_i   = curr_local[j];
+            double u_ip1 = curr_local[j + 1];
+
+            next_local[j] =
+                2.0 * u_i
+                -      old_local[j]
+                + coef[j] * (u_im1 - 2.0 * u_i + u_ip1);
+        }
+    }
+}
+
+static void update_float(void *next_v, const void *cur_v, const void *old_v,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max)
+{
+    float *next_local = next_v;
+    const float *curr_local = cur_v, *old_local = old_v;
+    const float c2 = (float)C2;
+
+    (void)coef;
+
+    for (int j = j_begin; j <= j_end; j++) {
+        int i_global = global_start + (j - HALO);
+        if (i_global == 0 || i_global == i_max - 1) {
+            next_local[j] = 0.0f;
+        } else {
+            float u_im1 = curr_local[j - 1];
+            float u_i   = curr_local[j];
+            float u_ip1 = curr_local[j + 1];
+
+            next_local[j] =
+                2.0f * u_i
+                -      old_local[j]
+                + c2 * (u_im1 - 2.0f * u_i + u_ip1);
+        }
+    }
+}
+
+/*
+ * Fourth-order update (WAVE_ORDER=4): the 5-point Laplacian
+ * (-u[i-2] + 16 u[i-1] - 30 u[i] + 16 u[i+1] - u[i+2]) / 12, with the wave
+ * continued as an odd mirror through the fixed ends (u[-1] = -u[1]), as in
+ * the lab_1 solvers. Reads two halo cells on each side.
+ */
+static void update_order4(void *next_v, const void *cur_v, const void *old_v,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max)
+{
+    double *next_local = next_v;
+    const double *curr_local = cur_v, *old_local = old_v;
+    const double c4 = C2 / 12.0;
+
+    (void)coef;
+
+    for (int j = j_begin; j <= j_end; j++) {
+        int i_global = global_start + (j - HALO);
+        if (i_global == 0 || i_global == i_max - 1) {
+            next_local[j] = 0.0;
+        } else {
+            double u_i   = curr_local[j];
+            double u_im2 = (i_global > 1) ? curr_local[j - 2] : -u_i;
+            double u_ip2 = (i_global < i_max - 2) ? curr_local[j + 2] : -u_i;
+
+            next_local[j] =
+                2.0 * u_i
+                -      old_local[j]
+                + c4 * (16.0 * (curr_local[j - 1] + curr_local[j + 1])
+                        - (u_im2 + u_ip2) - 30.0 * u_i);
+        }
+    }
+}
+
+/* float storage, double accumulation */
+static void update_mixed(void *next_v, const void *cur_v, const void *old_v,
+        const double *coef, int j_begin, int j_end, int global_start,
+        int i_max)
+{
+    float *next_local = next_v;
+    const float *curr_local = cur_v, *old_local = old_v;
+
+    (void)coef;
+
+    for (int j = j_begin; j <= j_end; j++) {
+        int i_global = global_start + (j - HALO);
+        if (i_global == 0 || i_global == i_max - 1) {
+            next_local[j] = 0.0f;
+        } else {
+            double u_im1 = curr_local[j - 1];
+            double u_i   = curr_local[j];
+            double u_ip1 = curr_local[j + 1];
+
+            next_local[j] = (float)(
+                2.0 * u_i
+                -      (double)old_local[j]
+                + C2 * (u_im1 - 2.0 * u_i + u_ip1));
+        }
+    }
+}
+
+/*
+ * Runs update on the local points [j_begin, j_end] that fall inside the
+ * active window [lo, hi] of global interior points; the rest of the wave is
+ * still exactly zero (2 * 0 - 0 + c * 0). The fixed ends are written every
+ * step whether or not the window covers them.
+ */
+static void update_window(update_fn_t update, void *next, const void *cur,
+        const void *old, const double *coef, int j_begin, int j_end,
+        int global_start, int i_max, int lo, int hi)
+{
+    int jl = lo - global_start + HALO;
+    int jh = hi - global_start + HALO;
+    int j0 = HALO - global_start;                 /* global 0 */
+    int j1 = i_max - 1 - global_start + HALO;     /* global i_max-1 */
+
+    if (jl < j_begin) jl = j_begin;
+    if (jh > j_end) jh = j_end;
+    if (jl <= jh)
+        update(next, cur, old, coef, jl, jh, global_start, i_max);
+    if (j0 >= j_begin && j0 <= j_end)
+        update(next, cur, old, coef, j0, j0, global_start, i_max);
+    if (j1 >= j_begin && j1 <= j_end)
+        update(next, cur, old, coef, j1, j1, global_start, i_max);
+}
+
+/*
+ * Smallest [*lo, *hi] within the interior holding every nonzero point of
+ * old and cur (lo > hi if there are none). WAVE_WINDOW=off returns the
+ * whole interior.
+ */
+static void active_window(const double *old, const double *cur, int i_max,
+        int *lo, int *hi)
+{
+    const char *env = getenv("WAVE_WINDOW");
+    int a = 1, b = i_max - 2;
+
+    if (!(env && strcmp(env, "off") == 0)) {
+        while (a <= b && old[a] == 0.0 && cur[a] == 0.0) a++;
+        while (b >= a && old[b] == 0.0 && cur[b] == 0.0) b--;
+    }
+    *lo = a;
+    *hi = b;
+}
+
+/* Spatial order selected by WAVE_ORDER (2 or 4) on the calling rank. */
+static int stencil_order(void)
+{
+    const char *env = getenv("WAVE_ORDER");
+    return (env && atoi(env) == 4) ? 4 : 2;
+}
+
+const wave_used_t *simulate_used(void)
+{
+    return &used;
+}
+
 /*
 Assignment 3.3
  * buffer: buffer address
@@ -106,6 +320,25 @@ int MYMPI_Bcast (void* buffer, int count , MPI_Datatype datatype, int root,
  * old_array: array of size i_max filled with data for t-1
  * current_array: array of size i_max filled with data for t
  * next_array: array of size i_max. You should fill this with t+1
+ *
+ * If rank 0 passes next_array == NULL every rank keeps two local arrays
+ * instead of three and overwrites old with next in place; the update reads
+ * old[j] only to compute next[j], so the result is the same.
+ *
+ * Only the active window of the wave is computed: rank 0 finds the part of
+ * the initial data that is nonzero, and every step it grows by one point on
+ * each side until it covers the string.
+ *
+ * With WAVE_PRECISION=float|mixed (as seen by rank 0) the local arrays and
+ * halo messages are single precision; data is converted when scattered and
+ * gathered, so the interface stays double.
+ *
+ * WAVE_COEFF=<file> (read by rank 0) gives every point its own c; the
+ * coefficients are scattered like the data and the update runs in double.
+ *
+ * WAVE_ORDER=4 (as seen by rank 0) selects the fourth-order stencil, which
+ * runs in double with a uniform c; the halos then carry two points, so
+ * every rank needs at least two.
  */
 double *simulate(const int i_max, const int t_max, double *old_array,
         double *current_array, double *next_array)
@@ -114,6 +347,49 @@ double *simulate(const int i_max, const int t_max, double *old_array,
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+    // Rank 0 decides the precision and buffer count so all ranks agree on
+    // message types, finds the initial active window and reads the
+    // coefficients, if c varies
+    int mode[6] = { 0, 0, 1, i_max - 2, 0, 2 };
+    const double *coef = NULL;
+    if (rank == 0) {
+        coef = wave_coeff(i_max);
+        mode[5] = stencil_order();
+        if (mode[5] == 4 && (coef || i_max / size < 2)) {
+            fprintf(stderr, "Fourth order needs a uniform c and two points "
+                    "per rank; using second order.\n");
+            mode[5] = 2;
+        }
+        mode[0] = (int)wave_precision();
+        if ((coef || mode[5] == 4) && mode[0] != WAVE_DOUBLE) {
+            fprintf(stderr, "Reduced precision needs a uniform c and the "
+                    "second-order stencil; using double.\n");
+            mode[0] = WAVE_DOUBLE;
+        }
+        mode[1] = (next_array == NULL);
+        active_window(old_array, current_array, i_max, &mode[2], &mode[3]);
+        mode[4] = (coef != NULL);
+
+        used.precision = (wave_precision_t)mode[0];
+        used.order = mode[5];
+        used.coef = coef;
+    }
+    MPI_Bcast(mode, 6, MPI_INT, 0, MPI_COMM_WORLD);
+    const int prec = mode[0];
+    const int in_place = mode[1];
+    int lo = mode[2], hi = mode[3];
+    const int has_coef = mode[4];
+    const int reach = mode[5] / 2;   /* halo points a step reads per side */
+
+    const int narrow = (prec != WAVE_DOUBLE);
+    const size_t elem = narrow ? sizeof(float) : sizeof(double);
+    const MPI_Datatype dtype = narrow ? MPI_FLOAT : MPI_DOUBLE;
+    const update_fn_t update = (prec == WAVE_FLOAT) ? update_float
+                             : (prec == WAVE_MIXED) ? update_mixed
+                             : has_coef ? update_coef
+                             : (reach == 2) ? update_order4
+                             : update_double;
+
     // Compute 1D block decomposition: how many points per process
     int base = i_max / size;
     int rem  = i_max % size;
@@ -134,35 +410,97 @@ double *simulate(const int i_max, const int t_max, double *old_array,
     }
     int global_start = displs[rank];
 
-    /* Local arrays include 2 halo cells: index 0 = left halo,
-       index local_n+1 = right halo */
-    double *old_local   = malloc((local_n + 2) * sizeof(double));
-    double *curr_local  = malloc((local_n + 2) * sizeof(double));
-    double *next_local  = malloc((local_n + 2) * sizeof(double));
+    /* Local arrays include HALO cells on each side: indices
+       0 .. HALO-1 = left halo, local_n+HALO .. = right halo. The left halo
+       sits just before a cache line so the interior starts on one. */
+    const size_t local_bytes = (local_n + 2 * HALO) * elem;
+    const size_t lead = HALO * elem;
+    const size_t stage_bytes = (local_n + 1) * sizeof(double);
+    char *old_local = NULL, *curr_local = NULL, *next_local = NULL;
+    double *stage = NULL, *coef_local = NULL;
+
+    if (wave_arena_reserve(&local_arena, 4 * WAVE_ARENA_CHUNK(local_bytes)
+                           + WAVE_ARENA_CHUNK(stage_bytes)) == 0) {
+        old_local  = wave_arena_alloc(&local_arena, local_bytes, lead);
+        curr_local = wave_arena_alloc(&local_arena, local_bytes, lead);
+        next_local = in_place ? old_local
+                              : wave_arena_alloc(&local_arena, local_bytes, lead);
+
+        /* Double staging buffer for scattering/gathering narrow arrays */
+        if (narrow)
+            stage = wave_arena_alloc(&local_arena, stage_bytes, 0);
+
+        /* coefficients share the data's layout, so coef[j] goes with
+           point j */
+        if (has_coef)
+            coef_local = wave_arena_alloc(&local_arena, local_bytes, lead);
+    }
 
-    if (!old_local || !curr_local || !next_local) {
+    if (!old_local || !curr_local || !next_local || (narrow && !stage)
+            || (has_coef && !coef_local)) {
         fprintf(stderr, "Rank %d: failed to allocate local arrays\n", rank);
         MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
+/* Address of local element j in a buffer of the selected precision */
+#define AT(buf, j) ((buf) + (size_t)(j) * elem)
+
     /* Scatter global initial data into local arrays (interior
-       part starts at index 1) */
-    MPI_Scatterv(old_array,     counts, displs, MPI_DOUBLE,
-                 &old_local[1], local_n,        MPI_DOUBLE,
-                 0, MPI_COMM_WORLD);
+       part starts at index HALO) */
+    if (!narrow) {
+        MPI_Scatterv(old_array,     counts, displs, MPI_DOUBLE,
+                     AT(old_local, HALO), local_n,  MPI_DOUBLE,
+                     0, MPI_COMM_WORLD);
+
+        MPI_Scatterv(current_array,     counts, displs, MPI_DOUBLE,
+                     AT(curr_local, HALO), local_n,     MPI_DOUBLE,
+                     0, MPI_COMM_WORLD);
+    } else {
+        float *o = (float *)old_local, *c = (float *)curr_local;
+
+        MPI_Scatterv(old_array, counts, displs, MPI_DOUBLE,
+                     stage,     local_n,        MPI_DOUBLE,
+                     0, MPI_COMM_WORLD);
+        for (int j = 0; j < local_n; j++) o[j + HALO] = (float)stage[j];
+
+        MPI_Scatterv(current_array, counts, displs, MPI_DOUBLE,
+                     stage,         local_n,        MPI_DOUBLE,
+                     0, MPI_COMM_WORLD);
+        for (int j = 0; j < local_n; j++) c[j + HALO] = (float)stage[j];
+    }
 
-    MPI_Scatterv(current_array,     counts, displs, MPI_DOUBLE,
-                 &curr_local[1],    local_n,        MPI_DOUBLE,
-                 0, MPI_COMM_WORLD);
+    if (has_coef) {
+        MPI_Scatterv(coef,           counts, displs, MPI_DOUBLE,
+                     coef_local + HALO, local_n,     MPI_DOUBLE,
+                     0, MPI_COMM_WORLD);
+    }
+
+    // next must read zero wherever the window has not reached yet
+    if (!in_place)
+        memset(next_local, 0, (local_n + 2 * HALO) * elem);
 
     // Initialise halos to zero; they will be overwritten for interior ranks
-    old_local[0] = old_local[local_n + 1] = 0.0;
-    curr_local[0] = curr_local[local_n + 1] = 0.0;
-    next_local[0] = next_local[local_n + 1] = 0.0;
+    memset(AT(old_local, 0), 0, lead);
+    memset(AT(old_local, local_n + HALO), 0, lead);
+    memset(AT(curr_local, 0), 0, lead);
+    memset(AT(curr_local, local_n + HALO), 0, lead);
+    memset(AT(next_local, 0), 0, lead);
+    memset(AT(next_local, local_n + HALO), 0, lead);
+
+    // First and last interior point, and the reach points next to each
+    // end that are sent to the neighbours
+    const int jb = HALO, je = HALO + local_n - 1;
+    const int js = HALO + local_n - reach;
 
     // Time-stepping loop
     for (int t = 0; t < t_max; t++) {
 
+        // the nonzero part grows by at most reach points per side and step
+        if (lo <= hi) {
+            lo = (lo - reach > 1) ? lo - reach : 1;
+            hi = (hi + reach < i_max - 2) ? hi + reach : i_max - 2;
+        }
+
         #ifdef USE_NONBLOCKING
             /* --- 3.2: fully non-blocking halo exchange --- */
             MPI_Request reqs[4];
@@ -170,137 +508,101 @@ double *simulate(const int i_max, const int t_max, double *old_array,
 
             // Irecv halos
             if (rank > 0) {
-                MPI_Irecv(&curr_local[0], 1, MPI_DOUBLE,
+                MPI_Irecv(AT(curr_local, HALO - reach), reach, dtype,
                         rank - 1, 1, MPI_COMM_WORLD, &reqs[nreq++]);
             } else {
-                curr_local[0] = 0.0;
+                memset(AT(curr_local, 0), 0, lead);
             }
 
             if (rank < size - 1) {
-                MPI_Irecv(&curr_local[local_n + 1], 1, MPI_DOUBLE,
+                MPI_Irecv(AT(curr_local, je + 1), reach, dtype,
                         rank + 1, 0, MPI_COMM_WORLD, &reqs[nreq++]);
             } else {
-                curr_local[local_n + 1] = 0.0;
+                memset(AT(curr_local, je + 1), 0, lead);
             }
 
             // Isend boundaries
             if (rank > 0) {
-                MPI_Isend(&curr_local[1], 1, MPI_DOUBLE,
+                MPI_Isend(AT(curr_local, jb), reach, dtype,
                         rank - 1, 0, MPI_COMM_WORLD, &reqs[nreq++]);
             }
             if (rank < size - 1) {
-                MPI_Isend(&curr_local[local_n], 1, MPI_DOUBLE,
+                MPI_Isend(AT(curr_local, js), reach, dtype,
                         rank + 1, 1, MPI_COMM_WORLD, &reqs[nreq++]);
             }
 
-            // Compute interior j = 2 .. local_n-1
-            for (int j = 2; j <= local_n - 1; j++) {
-                int i_global = global_start + (j - 1);
-                if (i_global == 0 || i_global == i_max - 1) {
-                    next_local[j] = 0.0;
-                } else {
-                    double u_im1 = curr_local[j - 1];
-                    double u_i   = curr_local[j];
-                    double u_ip1 = curr_local[j + 1];
-
-                    next_local[j] =
-                        2.0 * u_i
-                        -      old_local[j]
-                        + C2 * (u_im1 - 2.0 * u_i + u_ip1);
-                }
-            }
+            // Compute the points that do not read the halos
+            update_window(update, next_local, curr_local, old_local,
+                          coef_local, jb + reach, je - reach,
+                          global_start, i_max, lo, hi);
 
             if (nreq > 0) {
                 MPI_Waitall(nreq, reqs, MPI_STATUSES_IGNORE);
             }
 
-            // Compute boundaries j=1 and j=local_n (if they exist)
-            if (local_n >= 1) {
-                int j = 1;
-                int i_global = global_start + (j - 1);
-                if (i_global == 0 || i_global == i_max - 1) {
-                    next_local[j] = 0.0;
-                } else {
-                    double u_im1 = curr_local[j - 1];
-                    double u_i   = curr_local[j];
-                    double u_ip1 = curr_local[j + 1];
-
-                    next_local[j] =
-                        2.0 * u_i
-                        -      old_local[j]
-                        + C2 * (u_im1 - 2.0 * u_i + u_ip1);
-                }
-            }
-            if (local_n >= 2) {
-                int j = local_n;
-                int i_global = global_start + (j - 1);
-                if (i_global == 0 || i_global == i_max - 1) {
-                    next_local[j] = 0.0;
-                } else {
-                    double u_im1 = curr_local[j - 1];
-                    double u_i   = curr_local[j];
-                    double u_ip1 = curr_local[j + 1];
-
-                    next_local[j] =
-                        2.0 * u_i
-                        -      old_local[j]
-                        + C2 * (u_im1 - 2.0 * u_i + u_ip1);
-                }
-            }
+            // Compute the reach points at either end (they may overlap
+            // when local_n < 2 * reach)
+            const int jl_end = (jb + reach - 1 < je) ? jb + reach - 1 : je;
+            const int jr_begin = (je - reach + 1 > jl_end) ? je - reach + 1
+                                                           : jl_end + 1;
+            update_window(update, next_local, curr_local, old_local,
+                          coef_local, jb, jl_end, global_start, i_max,
+                          lo, hi);
+            update_window(update, next_local, curr_local, old_local,
+                          coef_local, jr_begin, je, global_start, i_max,
+                          lo, hi);
 
         #else
             /* --- 3.1: blocking halo exchange via Sendrecv --- */
 
             if (rank > 0) {
-                MPI_Sendrecv(&curr_local[1],           1, MPI_DOUBLE, rank - 1, 0,
-                            &curr_local[0],           1, MPI_DOUBLE, rank - 1, 1,
-                            MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Sendrecv(AT(curr_local, jb),           reach, dtype,
+                             rank - 1, 0,
+                             AT(curr_local, HALO - reach), reach, dtype,
+                             rank - 1, 1,
+                             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
             } else {
-                curr_local[0] = 0.0;
+                memset(AT(curr_local, 0), 0, lead);
             }
 
             if (rank < size - 1) {
-                MPI_Sendrecv(&curr_local[local_n],     1, MPI_DOUBLE, rank + 1, 1,
-                            &curr_local[local_n + 1], 1, MPI_DOUBLE, rank + 1, 0,
-                            MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                MPI_Sendrecv(AT(curr_local, js),     reach, dtype, rank + 1, 1,
+                             AT(curr_local, je + 1), reach, dtype, rank + 1, 0,
+                             MPI_COMM_WORLD, MPI_STATUS_IGNORE);
             } else {
-                curr_local[local_n + 1] = 0.0;
+                memset(AT(curr_local, je + 1), 0, lead);
             }
 
-            // Compute all points j = 1 .. local_n (halos are already valid)
-            for (int j = 1; j <= local_n; j++) {
-                int i_global = global_start + (j - 1);
-                if (i_global == 0 || i_global == i_max - 1) {
-                    next_local[j] = 0.0;
-                } else {
-                    double u_im1 = curr_local[j - 1];
-                    double u_i   = curr_local[j];
-                    double u_ip1 = curr_local[j + 1];
-
-                    next_local[j] =
-                        2.0 * u_i
-                        -      old_local[j]
-                        + C2 * (u_im1 - 2.0 * u_i + u_ip1);
-                }
-            }
+            // Compute all points j = jb .. je (halos are already valid)
+            update_window(update, next_local, curr_local, old_local,
+                          coef_local, jb, je, global_start, i_max, lo, hi);
         #endif
 
             /* Rotate the three local arrays: old <- current, current <- next,
-               next <- old */
-            double *tmp   = old_local;
+               next <- old (or the new old when updating in place) */
+            char *tmp     = old_local;
             old_local     = curr_local;
             curr_local    = next_local;
-            next_local    = tmp;
+            next_local    = in_place ? old_local : tmp;
         }
 
     // Gather final current values back into current_array on rank 0
-    MPI_Gatherv(&curr_local[1], local_n, MPI_DOUBLE,
-                current_array,  counts,  displs, MPI_DOUBLE,
-                0, MPI_COMM_WORLD);
+    if (!narrow) {
+        MPI_Gatherv(AT(curr_local, HALO), local_n, MPI_DOUBLE,
+                    current_array,  counts,  displs, MPI_DOUBLE,
+                    0, MPI_COMM_WORLD);
+    } else {
+        const float *c = (const float *)curr_local;
+        for (int j = 0; j < local_n; j++) stage[j] = c[j + HALO];
+
+        MPI_Gatherv(stage,         local_n, MPI_DOUBLE,
+                    current_array, counts,  displs, MPI_DOUBLE,
+                    0, MPI_COMM_WORLD);
+    }
+#undef AT
 
-    free(old_local);
-    free(curr_local);
-    free(next_local);
+    if (rank == 0)
+        wave_arena_report(&local_arena, "rank 0 local");
     free(counts);
     free(displs);
 
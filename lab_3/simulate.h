@@ -4,6 +4,19 @@
 
 #pragma once
 
+#include "coeff.h"       /* wave_coeff(), from ../lab_1/common */
+#include "precision.h"   /* wave_precision(), wave_reference() */
+
+/* What the last simulate() call ran with on rank 0, after the fallbacks
+   between WAVE_ORDER, WAVE_PRECISION and WAVE_COEFF. */
+typedef struct {
+    wave_precision_t precision;
+    int order;             /* 2 or 4 */
+    const double *coef;    /* NULL for a uniform c */
+} wave_used_t;
+
+const wave_used_t *simulate_used(void);
+
 int MYMPI_Bcast (void* buffer, int count , MPI_Datatype datatype, int root,
         MPI_Comm communicator);
 